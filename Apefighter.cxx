@@ -17,13 +17,30 @@
     Use Android.mk or CMakeLists.txt with NDK r21+
     Add SDL2 as dependency in jni/Android.mk
   
+  Headless benchmark (no window or GPU, SDL2 core only):
+    g++ -std=c++17 -O2 -DAPEFIGHTER_HEADLESS Apefighter.cxx \
+        $(sdl2-config --cflags --libs) -o apefighter-bench
+    ./apefighter-bench [--ticks N] [--seed N] [--workers N] [--density X] [--resume-check] [--net] [scenario...]
+    ./apefighter-bench --replay session.afr   (from --record, see INPUT RECORDING)
+    Either binary takes --trace out.json for a Chrome/Perfetto timeline
+    (see TRACE RECORDER).
+    --net measures the co-op snapshot stream (see NET SNAPSHOTS).
+    Add -DAPEFIGHTER_EXACT_MATH to either build for libm instead of the
+    fast trig paths (see FAST MATH).
+  
+  Co-op: one device runs --host PORT and the other --join HOST:PORT on
+  the same network (see NET SESSION).
+  Startup logs its time to first frame and to fully warm (see WARM-UP).
+  
   Screen: 720x1600 portrait (Oppo A5 5G native)
 =======================================================
 */
 
 #include <SDL2/SDL.h>
+#ifndef APEFIGHTER_HEADLESS
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_mixer.h>
+#endif
 #include <cmath>
 #include <vector>
 #include <string>
@@ -32,17 +49,44 @@
 #include <ctime>
 #include <algorithm>
 #include <memory>
+#include <cstring>
+#include <atomic>
+#include <utility>
+#include <cstdio>
+#include <type_traits>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 // ==================== SCREEN CONSTANTS ====================
+// Logical layout. The width is fixed; the height follows the display's
+// aspect ratio (setLayout, from main or a replay header), so taller or
+// shorter phones get more or less sky instead of letterboxing. Set once
+// before the world is created and never changed while it runs.
 // Oppo A5 5G: 1600x720 (portrait = 720x1600)
-const int SCREEN_W = 720;
-const int SCREEN_H = 1600;
-const float ASPECT = (float)SCREEN_W / SCREEN_H;
+const int SCREEN_W     = 720;
+const int SCREEN_H_MIN = 1280;
+const int SCREEN_H_MAX = 1760;
+int   SCREEN_H = 1600;
+float ASPECT   = (float)SCREEN_W / SCREEN_H;
 
 // UI Scale factor for high-DPI (Oppo A5 5G ~269 PPI)
 const float UI_SCALE = 2.0f;
 const int HUD_H    = (int)(160 * UI_SCALE); // bottom HUD height
-const int PLAY_H   = SCREEN_H - HUD_H;       // playable area height
+int       PLAY_H   = SCREEN_H - HUD_H;       // playable area height
+
+void setLayout(int screenH) {
+    SCREEN_H = std::max(SCREEN_H_MIN, std::min(screenH, SCREEN_H_MAX));
+    PLAY_H   = SCREEN_H - HUD_H;
+    ASPECT   = (float)SCREEN_W / SCREEN_H;
+}
 
 // ==================== GAME STATES ====================
 enum GameState { STATE_MENU, STATE_PLAYING, STATE_PAUSED, STATE_GAMEOVER, STATE_WIN };
@@ -76,159 +120,845 @@ float dist2D(float x1, float y1, float x2, float y2) {
     float dx = x2-x1, dy = y2-y1;
     return sqrtf(dx*dx + dy*dy);
 }
+// Squared distance, for radius tests (compare against r*r, no sqrtf)
+inline float dist2DSq(float x1, float y1, float x2, float y2) {
+    float dx = x2-x1, dy = y2-y1;
+    return dx*dx + dy*dy;
+}
+
+// ==================== FAST MATH ====================
+// Table sine/cosine, approximate atan2 and reciprocal square root for
+// code where a few 1e-3 of error can't be seen: particles, spinners,
+// bobbing, menu animation, missile steering. Enemy aim, boss spread and
+// wave motion stay on libm so the bench hashes only move with gameplay.
+// Build with -DAPEFIGHTER_EXACT_MATH to route these to libm as well,
+// which reproduces the exact-math hashes, for benchmarking both.
+const int SIN_TABLE_SIZE = 1024;   // power of two; samples per turn
+
+struct SinTable { float v[SIN_TABLE_SIZE + 1]; };   // +1: lerp past the end
+
+// Taylor series on [-pi, pi], in double; evaluated by the compiler
+constexpr double tableSin(double x) {
+    const double pi = 3.14159265358979323846;
+    if (x > pi) x -= 2 * pi;
+    double term = x, sum = x;
+    for (int n = 1; n < 14; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr SinTable makeSinTable() {
+    SinTable t = {};
+    for (int i = 0; i <= SIN_TABLE_SIZE; i++)
+        t.v[i] = (float)tableSin(2 * 3.14159265358979323846 * (i % SIN_TABLE_SIZE) / SIN_TABLE_SIZE);
+    return t;
+}
+
+constexpr SinTable SIN_TABLE = makeSinTable();
+
+#ifdef APEFIGHTER_EXACT_MATH
+inline float fsin(float a) { return sinf(a); }
+inline float fcos(float a) { return cosf(a); }
+inline float fatan2(float y, float x) { return atan2f(y, x); }
+inline void  fnormalize(float& dx, float& dy) {
+    float len = sqrtf(dx*dx + dy*dy);
+    if (len > 0) { dx /= len; dy /= len; }
+}
+#else
+// Any angle: the index wraps, so only |a| < ~1e6 rad loses precision
+inline float fsin(float a) {
+    float t = a * (SIN_TABLE_SIZE / (2 * (float)M_PI));
+    float fl = floorf(t);
+    int i = (int)fl & (SIN_TABLE_SIZE - 1);
+    return SIN_TABLE.v[i] + (SIN_TABLE.v[i + 1] - SIN_TABLE.v[i]) * (t - fl);
+}
+inline float fcos(float a) { return fsin(a + (float)M_PI * 0.5f); }
+
+// Max error under 1e-5 rad (odd minimax polynomial on [0, 1])
+inline float fatan2(float y, float x) {
+    float ax = fabsf(x), ay = fabsf(y);
+    float mx = std::max(ax, ay), mn = std::min(ax, ay);
+    if (mx == 0) return 0;
+    float t = mn / mx, s = t * t;
+    float r = ((((-0.0117212f * s + 0.05265332f) * s - 0.11643287f) * s + 0.19354346f) * s
+               - 0.33262347f) * s * t + 0.99997726f * t;
+    if (ay > ax) r = (float)M_PI * 0.5f - r;
+    if (x < 0)   r = (float)M_PI - r;
+    return y < 0 ? -r : r;
+}
+
+// Bit-trick estimate plus two Newton steps: relative error ~5e-6
+inline float frsqrt(float v) {
+    Uint32 i;
+    memcpy(&i, &v, 4);
+    i = 0x5f3759df - (i >> 1);
+    float y;
+    memcpy(&y, &i, 4);
+    y *= 1.5f - 0.5f * v * y * y;
+    y *= 1.5f - 0.5f * v * y * y;
+    return y;
+}
+
+inline void fnormalize(float& dx, float& dy) {
+    float len2 = dx*dx + dy*dy;
+    if (len2 > 0) { float inv = frsqrt(len2); dx *= inv; dy *= inv; }
+}
+#endif
+
+// ==================== RANDOM ====================
+// xoshiro128** seeded through splitmix64. Each World owns its streams so
+// runs with the same seed and input replay exactly, and there is no libc
+// lock on the hot path. Streams never share state: cosmetic draws can be
+// added or removed without shifting gameplay.
+struct Rng {
+    Uint32 s[4];
+    
+    void seed(Uint64 seed, Uint64 stream) {
+        Uint64 z = seed ^ (stream * 0x9E3779B97F4A7C15ull);
+        for (int i = 0; i < 4; i += 2) {
+            // splitmix64
+            Uint64 x = (z += 0x9E3779B97F4A7C15ull);
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            x ^= x >> 31;
+            s[i] = (Uint32)x; s[i+1] = (Uint32)(x >> 32);
+        }
+    }
+    static Uint32 rotl(Uint32 x, int k) { return (x << k) | (x >> (32 - k)); }
+    Uint32 next() {
+        Uint32 result = rotl(s[1] * 5, 7) * 9;
+        Uint32 t = s[1] << 9;
+        s[2] ^= s[0]; s[3] ^= s[1]; s[1] ^= s[2]; s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+    // Uniform in [0, n), n > 0 (multiply-shift, no division)
+    int below(int n) { return (int)(((Uint64)next() * (Uint32)n) >> 32); }
+    // Uniform in [0, 1)
+    float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+};
+
+enum RngStream { RNG_GAMEPLAY, RNG_COSMETIC, RNG_RENDER };
 
 // Simple 3D -> 2D projection
 struct Camera3D {
     float fov = 60.0f;
     float near = 0.1f;
     float far  = 1000.0f;
+    float tanHalf = tanf(60.0f * (float)M_PI / 360.0f);   // kept by setFov
+    
+    void setFov(float deg) { fov = deg; tanHalf = tanf(deg * (float)M_PI / 360.0f); }
 };
 
-Vec2 project3D(Vec3 p, Camera3D& cam) {
-    float fovRad = cam.fov * M_PI / 180.0f;
-    float tanHalf = tanf(fovRad * 0.5f);
-    float sx = (p.x / (p.z * tanHalf * ASPECT)) * (SCREEN_W * 0.5f) + SCREEN_W * 0.5f;
-    float sy = (-p.y / (p.z * tanHalf)) * (SCREEN_H * 0.5f) + SCREEN_H * 0.5f;
+Vec2 project3D(Vec3 p, const Camera3D& cam) {
+    float sx = (p.x / (p.z * cam.tanHalf * ASPECT)) * (SCREEN_W * 0.5f) + SCREEN_W * 0.5f;
+    float sy = (-p.y / (p.z * cam.tanHalf)) * (SCREEN_H * 0.5f) + SCREEN_H * 0.5f;
     return { sx, sy };
 }
 
+// ==================== PROFILER ====================
+// Per-phase frame timings from SDL_GetPerformanceCounter. Phases that run
+// more than once per frame (sim steps) accumulate. Each frame's totals go
+// into a rolling history; the overlay (F3, or a three-finger tap) shows
+// p50/p95/p99 in ms plus draw calls, refreshed every PROF_REFRESH_FRAMES.
+enum ProfPhase {
+    PH_FRAME, PH_EVENTS, PH_SIM,
+    PH_SCROLL, PH_SPAWN, PH_GRID, PH_BULLETS, PH_MISSILES, PH_ENEMIES,
+    PH_EXPLOSIONS, PH_POWERUPS, PH_NET,
+    PH_BACKGROUND, PH_ENTITIES, PH_HUD, PH_WARMUP, PH_PRESENT,
+    PH_COUNT
+};
+const char* const PROF_PHASE_NAMES[PH_COUNT] = {
+    "FRAME", "EVENTS", "SIM",
+    "SCROLL", "SPAWN", "GRID", "BULLETS", "MISSILES", "ENEMIES",
+    "EXPLODE", "POWERUPS", "NET",
+    "BACKGND", "ENTITIES", "HUD", "WARMUP", "PRESENT",
+};
+
+const int PROF_HISTORY        = 128; // frames of history per phase
+const int PROF_REFRESH_FRAMES = 30;
+
+// Timings of one frame. Each thread adds into its own (t_prof); the sim
+// thread hands its totals over with the snapshot (see PIPELINE).
+struct ProfTicks {
+    Uint64 ticks[PH_COUNT] = {};
+    int    simSteps = 0;
+    
+    void mergeFrom(const ProfTicks& o) {
+        for (int i = 0; i < PH_COUNT; i++) ticks[i] += o.ticks[i];
+        simSteps += o.simSteps;
+    }
+};
+
+struct Profiler {
+    bool      show = false;
+    double    msPerTick = 0;
+    ProfTicks frame;                           // this frame, main thread
+    float     history[PH_COUNT][PROF_HISTORY] = {};
+    int       drawCalls = 0;                   // this frame
+    int       drawHistory[PROF_HISTORY] = {};
+    int    frames = 0;                         // frames recorded
+    // Overlay lines, rebuilt every PROF_REFRESH_FRAMES
+    char   lines[PH_COUNT + 1][32] = {};
+};
+Profiler g_prof;
+thread_local ProfTicks* t_prof = &g_prof.frame;
+thread_local int*       t_drawCalls = &g_prof.drawCalls;   // the warm-up thread keeps its own
+
+// Every timed phase is also a span for the trace recorder when it is on
+// (see TRACE RECORDER)
+extern std::atomic<bool> g_traceOn;
+void traceSpan(int phase, Uint64 t0, Uint64 t1);
+
+inline Uint64 profNow() { return SDL_GetPerformanceCounter(); }
+inline void   profAdd(int phase, Uint64 t0) {
+    Uint64 t = profNow();
+    t_prof->ticks[phase] += t - t0;
+    if (g_traceOn.load(std::memory_order_relaxed)) traceSpan(phase, t0, t);
+}
+inline void   profDrawCall() { (*t_drawCalls)++; }
+
+// Times the enclosing block
+struct ProfileScope {
+    int phase; Uint64 t0;
+    explicit ProfileScope(int ph) : phase(ph), t0(profNow()) {}
+    ~ProfileScope() { profAdd(phase, t0); }
+};
+
+// Times consecutive sections of one function: each next() closes the
+// running phase and opens another; the destructor closes the last
+struct ProfileLap {
+    int phase = -1; Uint64 t0 = 0;
+    void next(int ph) {
+        Uint64 t = profNow();
+        if (phase >= 0) {
+            t_prof->ticks[phase] += t - t0;
+            if (g_traceOn.load(std::memory_order_relaxed)) traceSpan(phase, t0, t);
+        }
+        phase = ph; t0 = t;
+    }
+    void stop() { if (phase >= 0) profAdd(phase, t0); phase = -1; }
+    ~ProfileLap() { stop(); }
+};
+
+// Reorders v[0, n)
+float percentile(float* v, int n, float q) {
+    int k = (int)(q * (n - 1));
+    std::nth_element(v, v + k, v + n);
+    return v[k];
+}
+
+void buildProfilerLines() {
+    Profiler& pf = g_prof;
+    int n = std::min(pf.frames, PROF_HISTORY);
+    if (n == 0) return;
+    float v[PROF_HISTORY];
+    for (int i = 0; i < PH_COUNT; i++) {
+        std::copy(pf.history[i], pf.history[i] + n, v);
+        snprintf(pf.lines[i], sizeof pf.lines[i], "%-8s %5.2f %5.2f %5.2f",
+                 PROF_PHASE_NAMES[i], percentile(v, n, 0.5f), percentile(v, n, 0.95f), percentile(v, n, 0.99f));
+    }
+    int maxDraws = *std::max_element(pf.drawHistory, pf.drawHistory + n);
+    snprintf(pf.lines[PH_COUNT], sizeof pf.lines[PH_COUNT], "DRAWS %d MAX %d STEPS %d",
+             pf.drawCalls, maxDraws, pf.frame.simSteps);
+}
+
+// For runs without the overlay (replays): the last PROF_HISTORY frames
+void logProfilerSummary() {
+    buildProfilerLines();
+    SDL_Log("frames %d, last %d (ms): PHASE P50 P95 P99", g_prof.frames, std::min(g_prof.frames, PROF_HISTORY));
+    for (int i = 0; i <= PH_COUNT; i++) SDL_Log("%s", g_prof.lines[i]);
+}
+
+// Commits this frame's totals to the history; call once per frame
+void endProfileFrame() {
+    Profiler& pf = g_prof;
+    if (pf.msPerTick == 0) pf.msPerTick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    int slot = pf.frames % PROF_HISTORY;
+    for (int i = 0; i < PH_COUNT; i++) {
+        pf.history[i][slot] = (float)(pf.frame.ticks[i] * pf.msPerTick);
+    }
+    pf.drawHistory[slot] = pf.drawCalls;
+    pf.frames++;
+    
+    if (pf.show && pf.frames % PROF_REFRESH_FRAMES == 0)
+        buildProfilerLines();
+    pf.drawCalls = 0;
+    pf.frame = {};
+}
+
+// ==================== TRACE RECORDER ====================
+// Off-device frame timelines. While on (--trace PATH, or trace.on in the
+// pref path) every profiler phase is recorded as a span, tagged with the
+// thread it ran on, and the main loop adds a few counters per frame. All
+// of it lands in one lock-free ring shared by every thread, newest
+// overwriting oldest, and saveTrace writes what the ring holds as Chrome
+// trace JSON (chrome://tracing, ui.perfetto.dev). Saved on F4, at game
+// over and at exit. Off, the cost is one relaxed load per phase.
+enum TraceCounter { TC_BULLETS, TC_MISSILES, TC_ENEMIES, TC_PARTICLES, TC_DRAWS, TC_STEPS,
+                    TC_NET_BYTES, TC_WARM_JOBS, TC_COUNT };
+const char* const TRACE_COUNTER_NAMES[TC_COUNT] = {
+    "bullets", "missiles", "enemies", "particles", "draw calls", "sim steps", "net bytes/s",
+    "warm-up jobs",
+};
+
+const int TRACE_CAPACITY = 1 << 16;   // events, ~2 MB
+const int TRACE_TID_MAIN = 0;
+const int TRACE_TID_SIM  = 1;         // job workers follow: slot + 1
+const int TRACE_TID_WARM = 255;       // the startup warm-up thread (see WARM-UP)
+
+// Fields are relaxed atomics so a save can run while other threads keep
+// recording; seq (index + 1, 0 while being written) rejects torn slots
+struct TraceEvent {
+    std::atomic<Uint32> seq;
+    std::atomic<Uint32> what;   // kind << 24 | tid << 16 | phase or counter
+    std::atomic<Uint64> t0, t1; // span end, or counter value for counters
+};
+enum TraceKind { TK_SPAN, TK_COUNTER };
+
+struct TraceRecorder {
+    std::vector<TraceEvent> ring;   // TRACE_CAPACITY once started
+    std::atomic<Uint32> head{0};
+    Uint32 savedHead = 0;   // head at the last save
+    Uint64 base = 0;        // counter at start, the trace's time zero
+    std::string path;
+    int saves = 0;
+};
+TraceRecorder g_trace;
+std::atomic<bool> g_traceOn{false};
+thread_local int t_traceTid = TRACE_TID_MAIN;
+
+void startTrace(const char* path) {
+    TraceRecorder& tr = g_trace;
+    std::vector<TraceEvent>(TRACE_CAPACITY).swap(tr.ring);
+    for (int i = 0; i < TRACE_CAPACITY; i++) tr.ring[i].seq.store(0, std::memory_order_relaxed);
+    tr.path = path;
+    tr.base = profNow();
+    g_traceOn.store(true, std::memory_order_release);
+    SDL_Log("Trace: recording to %s (last %d events)", path, TRACE_CAPACITY);
+}
+
+void traceRecord(Uint32 what, Uint64 t0, Uint64 t1) {
+    TraceRecorder& tr = g_trace;
+    Uint32 i = tr.head.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent& e = tr.ring[i & (TRACE_CAPACITY - 1)];
+    e.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.what.store(what, std::memory_order_relaxed);
+    e.t0.store(t0, std::memory_order_relaxed);
+    e.t1.store(t1, std::memory_order_relaxed);
+    e.seq.store(i + 1, std::memory_order_release);
+}
+
+void traceSpan(int phase, Uint64 t0, Uint64 t1) {
+    traceRecord((Uint32)TK_SPAN << 24 | (Uint32)t_traceTid << 16 | (Uint32)phase, t0, t1);
+}
+
+inline void traceCounter(int counter, Uint64 value) {
+    if (!g_traceOn.load(std::memory_order_relaxed)) return;
+    traceRecord((Uint32)TK_COUNTER << 24 | (Uint32)t_traceTid << 16 | (Uint32)counter, profNow(), value);
+}
+
+// Writes the ring's contents, oldest first. Returns false if nothing new
+// was recorded since the last save or the file can't be written.
+bool saveTrace(const char* why) {
+    TraceRecorder& tr = g_trace;
+    if (tr.ring.empty()) return false;
+    Uint32 head = tr.head.load(std::memory_order_acquire);
+    if (head == tr.savedHead) return false;
+    SDL_RWops* f = SDL_RWFromFile(tr.path.c_str(), "wb");
+    if (!f) {
+        SDL_Log("Trace: can't write %s: %s", tr.path.c_str(), SDL_GetError());
+        return false;
+    }
+    double usPerTick = 1e6 / (double)SDL_GetPerformanceFrequency();
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    char buf[160];
+    bool tidSeen[256] = {};
+    Uint32 first = head > (Uint32)TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+    int written = 0;
+    for (Uint32 i = first; i != head; i++) {
+        TraceEvent& e = tr.ring[i & (TRACE_CAPACITY - 1)];
+        if (e.seq.load(std::memory_order_acquire) != i + 1) continue;
+        Uint32 what = e.what.load(std::memory_order_relaxed);
+        Uint64 t0 = e.t0.load(std::memory_order_relaxed), t1 = e.t1.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (e.seq.load(std::memory_order_relaxed) != i + 1) continue;   // overwritten meanwhile
+        int kind = what >> 24, tid = (what >> 16) & 0xff, id = what & 0xffff;
+        double ts = (double)(Sint64)(t0 - tr.base) * usPerTick;
+        if (!tidSeen[tid]) {
+            tidSeen[tid] = true;
+            char name[16];
+            if (tid == TRACE_TID_MAIN)     snprintf(name, sizeof name, "main");
+            else if (tid == TRACE_TID_SIM) snprintf(name, sizeof name, "sim");
+            else if (tid == TRACE_TID_WARM) snprintf(name, sizeof name, "warm-up");
+            else                           snprintf(name, sizeof name, "worker %d", tid - TRACE_TID_SIM);
+            snprintf(buf, sizeof buf, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,"
+                     "\"args\":{\"name\":\"%s\"}},\n", tid, name);
+            out += buf;
+        }
+        if (kind == TK_SPAN && id < PH_COUNT)
+            snprintf(buf, sizeof buf, "{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,"
+                     "\"ts\":%.3f,\"dur\":%.3f},\n", PROF_PHASE_NAMES[id], tid, ts, (t1 - t0) * usPerTick);
+        else if (kind == TK_COUNTER && id < TC_COUNT)
+            snprintf(buf, sizeof buf, "{\"ph\":\"C\",\"name\":\"%s\",\"pid\":1,\"ts\":%.3f,"
+                     "\"args\":{\"value\":%llu}},\n", TRACE_COUNTER_NAMES[id], ts, (unsigned long long)t1);
+        else continue;
+        out += buf;
+        written++;
+    }
+    if (out.size() > 2 && out[out.size() - 2] == ',') out.erase(out.size() - 2, 1);
+    out += "]}\n";
+    bool ok = SDL_RWwrite(f, out.data(), 1, out.size()) == out.size();
+    SDL_RWclose(f);
+    tr.savedHead = head;
+    tr.saves++;
+    SDL_Log("Trace: %d events to %s (%s)%s", written, tr.path.c_str(), why, ok ? "" : ", write failed");
+    return ok;
+}
+
+// ==================== QUALITY GOVERNOR ====================
+// Watches frame times from the profiler history and steps the renderer
+// through quality tiers. Each window of GOV_WINDOW playing frames is
+// judged over budget (p90 frame time misses the display interval, or the
+// CPU work alone nearly fills it), under budget (comfortable headroom),
+// or neither. It takes GOV_DROP_WINDOWS bad windows in a row to drop a
+// tier and raiseAfter good ones to go back up; a tier that has to be
+// abandoned soon after being raised to doubles raiseAfter, so a device on
+// the edge settles instead of flip-flopping. Tiers are render-only: the
+// sim, and so replays and the bench, never see them.
+struct QualityTier {
+    const char* name;
+    int   starLayers;      // baked star strips drawn, far ones dropped first
+    int   cloudLayers;     // baked cloud strips drawn, far ones dropped first
+    int   sparkEvery;      // draw every Nth spark, 0 none
+    int   particleBudget;  // discs drawn per frame, newest first
+    float bgScale;         // resolution the background is baked at
+    float playScale;       // resolution of the play-field target, 1 = native
+};
+
+const QualityTier QUALITY_TIERS[] = {
+    { "HIGH",   2, 2, 1, 2048, 1.0f, 1.0f  },
+    { "MEDIUM", 2, 2, 2,  768, 1.0f, 1.0f  },
+    { "LOW",    1, 1, 4,  384, 0.5f, 0.75f },
+    { "MIN",    1, 0, 0,  192, 0.5f, 0.5f  },
+};
+const int QUALITY_TIER_COUNT = sizeof QUALITY_TIERS / sizeof QUALITY_TIERS[0];
+
+const int GOV_WINDOW        = 60;   // frames per decision
+const int GOV_DROP_WINDOWS  = 2;
+const int GOV_RAISE_WINDOWS = 5;
+const int GOV_RAISE_MAX     = 80;
+
+struct QualityGovernor {
+    int   tier       = 0;
+    bool  pinned     = false;   // --quality N
+    float playScaleOverride = 0;  // --play-scale X, 0 = per tier
+    float budgetMs   = 1000.0f / 60;
+    int   frames     = 0;       // into the current window
+    float frameMs[GOV_WINDOW];
+    float busyMs[GOV_WINDOW];   // frame minus present, i.e. without the vsync wait
+    int   badWindows = 0, goodWindows = 0;
+    int   raiseAfter = GOV_RAISE_WINDOWS;
+    int   windowsSinceRaise = -1;   // -1: no raise to regret
+    int   changes    = 0;
+    char  line[32]   = {};      // for the profiler overlay
+};
+QualityGovernor g_quality;
+
+inline const QualityTier& qualityTier() { return QUALITY_TIERS[g_quality.tier]; }
+inline float playScale() {
+    return g_quality.playScaleOverride > 0 ? g_quality.playScaleOverride : qualityTier().playScale;
+}
+
+void initQuality(SDL_Window* win, int pinnedTier) {
+    QualityGovernor& q = g_quality;
+    SDL_DisplayMode mode;
+    if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(win), &mode) == 0 && mode.refresh_rate > 0)
+        q.budgetMs = 1000.0f / mode.refresh_rate;
+    if (pinnedTier >= 0) {
+        q.tier = std::min(pinnedTier, QUALITY_TIER_COUNT - 1);
+        q.pinned = true;
+    }
+    snprintf(q.line, sizeof q.line, "QUALITY %s", qualityTier().name);
+    SDL_Log("Quality: %s%s, frame budget %.1f ms", qualityTier().name,
+            q.pinned ? " (pinned)" : "", q.budgetMs);
+}
+
+void setQualityTier(int tier, float p90, float busy) {
+    QualityGovernor& q = g_quality;
+    q.tier = tier;
+    q.changes++;
+    SDL_Log("Quality: %s (frame p90 %.1f ms, busy %.1f ms, budget %.1f ms)",
+            qualityTier().name, p90, busy, q.budgetMs);
+}
+
+// Call once per frame after endProfileFrame; only frames in play count
+void updateQuality(bool playing) {
+    QualityGovernor& q = g_quality;
+    if (q.pinned) return;
+    if (!playing) { q.frames = 0; return; }
+    const Profiler& pf = g_prof;
+    int slot = (pf.frames - 1) % PROF_HISTORY;
+    q.frameMs[q.frames] = pf.history[PH_FRAME][slot];
+    q.busyMs[q.frames]  = pf.history[PH_FRAME][slot] - pf.history[PH_PRESENT][slot];
+    if (++q.frames < GOV_WINDOW) return;
+    q.frames = 0;
+    
+    float v[GOV_WINDOW];   // no heap on the render thread
+    std::copy(q.frameMs, q.frameMs + GOV_WINDOW, v);
+    float p90 = percentile(v, GOV_WINDOW, 0.9f);
+    float busy = 0;
+    for (float b : q.busyMs) busy += b;
+    busy /= GOV_WINDOW;
+    snprintf(q.line, sizeof q.line, "QUALITY %s %.1f %.1f", qualityTier().name, p90, busy);
+    
+    bool over  = p90 > q.budgetMs * 1.25f || busy > q.budgetMs * 0.9f;
+    bool under = p90 < q.budgetMs * 1.1f  && busy < q.budgetMs * 0.5f;
+    if (q.windowsSinceRaise >= 0) q.windowsSinceRaise++;
+    if (over) {
+        q.goodWindows = 0;
+        if (++q.badWindows >= GOV_DROP_WINDOWS && q.tier < QUALITY_TIER_COUNT - 1) {
+            // Dropping straight back from a raise: be slower to try again
+            if (q.windowsSinceRaise >= 0 && q.windowsSinceRaise <= 4 * GOV_DROP_WINDOWS)
+                q.raiseAfter = std::min(q.raiseAfter * 2, GOV_RAISE_MAX);
+            q.windowsSinceRaise = -1;
+            q.badWindows = 0;
+            setQualityTier(q.tier + 1, p90, busy);
+        }
+    } else if (under) {
+        q.badWindows = 0;
+        if (++q.goodWindows >= q.raiseAfter && q.tier > 0) {
+            q.goodWindows = 0;
+            q.windowsSinceRaise = 0;
+            setQualityTier(q.tier - 1, p90, busy);
+        }
+    } else {
+        q.badWindows = q.goodWindows = 0;
+    }
+}
+
+// ==================== PRIMITIVE BATCH ====================
+// fillRect, drawCircle and drawRing append triangles to one vertex buffer
+// that is submitted with a single SDL_RenderGeometry. The buffer always
+// holds one blend mode: setBlendMode, setClip and every direct SDL draw
+// (lines, texture copies, target switches, present) flush it first so
+// painter's order is preserved. One per thread, so the warm-up thread can
+// rasterize caches with the same helpers while the main thread draws.
+struct PrimBatch {
+    SDL_Renderer*           r = nullptr;
+    std::vector<SDL_Vertex> verts;
+    std::vector<int>        indices;
+};
+thread_local PrimBatch g_prims;
+
+const int PRIM_BATCH_FLUSH_VERTS = 16384;
+
+void flushPrims(SDL_Renderer* r) {
+    PrimBatch& b = g_prims;
+    if (b.r && !b.indices.empty()) {
+        SDL_RenderGeometry(b.r, nullptr, b.verts.data(), (int)b.verts.size(),
+                           b.indices.data(), (int)b.indices.size());
+        profDrawCall();
+    }
+    b.verts.clear();
+    b.indices.clear();
+    b.r = r;
+}
+
+// Returns the index of the first new vertex
+inline int beginPrims(SDL_Renderer* r, int nverts) {
+    PrimBatch& b = g_prims;
+    if (b.r != r || (int)b.verts.size() + nverts > PRIM_BATCH_FLUSH_VERTS) flushPrims(r);
+    return (int)b.verts.size();
+}
+
+inline void primVertex(float x, float y, Color c) {
+    SDL_Vertex v;
+    v.position  = { x, y };
+    v.color     = { c.r, c.g, c.b, c.a };
+    v.tex_coord = { 0, 0 };
+    g_prims.verts.push_back(v);
+}
+
+inline void primTri(int a, int b, int c) {
+    g_prims.indices.push_back(a);
+    g_prims.indices.push_back(b);
+    g_prims.indices.push_back(c);
+}
+
+// Segments for a circle of the given radius: enough that the fan edge
+// stays within about a pixel of the scanline circle it replaces
+inline int circleSegments(float radius) {
+    int n = (int)(radius * 1.5f);
+    return n < 8 ? 8 : n > 64 ? 64 : n;
+}
+
 // ==================== SDL DRAW HELPERS ====================
 void setColor(SDL_Renderer* r, Color c) {
     SDL_SetRenderDrawColor(r, c.r, c.g, c.b, c.a);
 }
 
+void setBlendMode(SDL_Renderer* r, SDL_BlendMode mode) {
+    flushPrims(r);
+    SDL_SetRenderDrawBlendMode(r, mode);
+}
+
+void setClip(SDL_Renderer* r, const SDL_Rect* clip) {
+    flushPrims(r);
+    SDL_RenderSetClipRect(r, clip);
+}
+
+void renderCopy(SDL_Renderer* r, SDL_Texture* tex, const SDL_Rect* src, const SDL_Rect* dst) {
+    flushPrims(r);
+    SDL_RenderCopy(r, tex, src, dst);
+    profDrawCall();
+}
+
 void fillRect(SDL_Renderer* r, int x, int y, int w, int h, Color c) {
-    setColor(r, c);
-    SDL_Rect rect = {x, y, w, h};
-    SDL_RenderFillRect(r, &rect);
+    if (w <= 0 || h <= 0) return;
+    int v = beginPrims(r, 4);
+    float x0 = (float)x, y0 = (float)y, x1 = (float)(x + w), y1 = (float)(y + h);
+    primVertex(x0, y0, c);
+    primVertex(x1, y0, c);
+    primVertex(x1, y1, c);
+    primVertex(x0, y1, c);
+    primTri(v, v+1, v+2);
+    primTri(v, v+2, v+3);
 }
 
 void drawCircle(SDL_Renderer* r, int cx, int cy, int radius, Color c) {
-    setColor(r, c);
-    for (int dy = -radius; dy <= radius; dy++) {
-        int dx = (int)sqrtf((float)(radius*radius - dy*dy));
-        SDL_RenderDrawLine(r, cx-dx, cy+dy, cx+dx, cy+dy);
+    if (radius < 0) return;
+    // Fan around the pixel centre; +0.5 matches the inclusive scanline span
+    float fx = cx + 0.5f, fy = cy + 0.5f, rad = radius + 0.5f;
+    int n = circleSegments(rad);
+    int v = beginPrims(r, n + 1);
+    primVertex(fx, fy, c);
+    for (int i = 0; i < n; i++) {
+        float a = i * (float)(2 * M_PI) / n;
+        primVertex(fx + fcos(a) * rad, fy + fsin(a) * rad, c);
     }
+    for (int i = 0; i < n; i++)
+        primTri(v, v + 1 + i, v + 1 + (i + 1) % n);
 }
 
 void drawRing(SDL_Renderer* r, int cx, int cy, int outer, int inner, Color c) {
-    setColor(r, c);
-    for (int dy = -outer; dy <= outer; dy++) {
-        int dx_o = (int)sqrtf(std::max(0.0f, (float)(outer*outer - dy*dy)));
-        int dx_i = (abs(dy) > inner) ? 0 : (int)sqrtf((float)(inner*inner - dy*dy));
-        SDL_RenderDrawLine(r, cx-dx_o, cy+dy, cx-dx_i, cy+dy);
-        SDL_RenderDrawLine(r, cx+dx_i, cy+dy, cx+dx_o, cy+dy);
+    if (inner <= 0) { drawCircle(r, cx, cy, outer, c); return; }
+    float fx = cx + 0.5f, fy = cy + 0.5f;
+    float ro = outer + 0.5f, ri = inner - 0.5f;
+    int n = circleSegments(ro);
+    int v = beginPrims(r, n * 2);
+    for (int i = 0; i < n; i++) {
+        float a = i * (float)(2 * M_PI) / n;
+        float ca = fcos(a), sa = fsin(a);
+        primVertex(fx + ca * ro, fy + sa * ro, c);
+        primVertex(fx + ca * ri, fy + sa * ri, c);
+    }
+    for (int i = 0; i < n; i++) {
+        int o0 = v + 2*i, i0 = o0 + 1;
+        int o1 = v + 2*((i + 1) % n), i1 = o1 + 1;
+        primTri(o0, o1, i1);
+        primTri(o0, i1, i0);
     }
 }
 
 void drawLine(SDL_Renderer* r, int x1, int y1, int x2, int y2, Color c) {
+    flushPrims(r);
     setColor(r, c);
     SDL_RenderDrawLine(r, x1, y1, x2, y2);
+    profDrawCall();
+}
+
+// ==================== PIXEL FONT (3x5 bitmap) ====================
+// Text is drawn with a 3x5 pixel font (no TTF needed). Each glyph row is a
+// 3-bit mask, MSB = leftmost pixel. Characters not in the table draw blank.
+struct GlyphDef { char c; Uint8 rows[5]; };
+constexpr GlyphDef GLYPH_DEFS[] = {
+    { '0', {7,5,5,5,7} }, { '1', {3,1,1,1,7} }, { '2', {7,1,7,4,7} }, { '3', {7,1,7,1,7} },
+    { '4', {5,5,7,1,1} }, { '5', {7,4,7,1,7} }, { '6', {7,4,7,5,7} }, { '7', {7,1,1,1,1} },
+    { '8', {7,5,7,5,7} }, { '9', {7,5,7,1,7} }, { 'A', {7,5,7,5,5} }, { 'B', {6,5,7,5,6} },
+    { 'C', {7,4,4,4,7} }, { 'D', {6,5,5,5,6} }, { 'E', {7,4,7,4,7} }, { 'F', {7,4,7,4,4} },
+    { 'G', {7,4,5,5,7} }, { 'H', {5,5,7,5,5} }, { 'I', {7,2,2,2,7} }, { 'J', {1,1,1,5,7} },
+    { 'K', {5,5,6,5,5} }, { 'L', {4,4,4,4,7} }, { 'M', {5,7,5,5,5} }, { 'N', {5,7,7,5,5} },
+    { 'O', {7,5,5,5,7} }, { 'P', {7,5,7,4,4} }, { 'Q', {7,5,5,7,1} }, { 'R', {7,5,7,5,5} },
+    { 'S', {7,4,7,1,7} }, { 'T', {7,2,2,2,2} }, { 'U', {5,5,5,5,7} }, { 'V', {5,5,5,5,2} },
+    { 'W', {5,5,5,7,5} }, { 'X', {5,5,2,5,5} }, { 'Y', {5,5,7,2,2} }, { 'Z', {7,1,2,4,7} },
+    { ':', {0,2,0,2,0} }, { '-', {0,0,7,0,0} }, { '/', {1,2,2,4,4} }, { '%', {5,1,2,4,5} },
+    { '!', {2,2,2,0,2} }, { '.', {0,0,0,0,2} }, { '+', {0,2,7,2,0} }, { '*', {5,2,7,2,5} },
+    { '<', {1,2,4,2,1} }, { '>', {4,2,1,2,4} },
+};
+
+struct Font3x5 { Uint8 rows[128][5]; };
+constexpr Font3x5 buildFont3x5() {
+    Font3x5 f = {};
+    for (const GlyphDef& d : GLYPH_DEFS)
+        for (int i = 0; i < 5; i++) f.rows[(int)d.c][i] = d.rows[i];
+    return f;
+}
+constexpr Font3x5 FONT3x5 = buildFont3x5();
+
+const int GLYPH_ADVANCE = 4; // 3px glyph + 1px spacing, at scale 1
+
+inline const Uint8* glyphRows(char c) {
+    return FONT3x5.rows[(unsigned char)c & 127];
 }
 
-// Draw text using filled rectangles (pixel font, no TTF needed)
-void drawPixelChar(SDL_Renderer* r, int x, int y, char ch, int sz, Color c);
-void drawText(SDL_Renderer* r, const std::string& txt, int x, int y, int sz, Color c);
+// ==================== TEXT CACHE ====================
+// drawPixelText on the main renderer goes through two texture caches:
+//  - a glyph atlas with every glyph at scale 1, built once from FONT3x5
+//  - rendered strings keyed by their text, so an entry is only rebuilt
+//    when a call site's text changes; stale keys age out LRU
+// Color and scale are applied at draw time (color mod, nearest scaling),
+// so one entry serves every call site that draws the same text.
+const int TEXT_CACHE_SLOTS         = 64;
+const int TEXT_CACHE_MAX_LEN       = 31;
+const int TEXT_CACHE_NEW_PER_FRAME = 8; // uploads per frame before falling back to glyphs
 
-// ==================== PIXEL FONT (5x7 bitmap) ====================
-// Minimal 5x7 bitmap font for digits, letters, !, :, /, .
-static const uint8_t FONT5x7[128][7] = {
-    // Fill with zeros first; we'll define key chars
-    [0 ... 127] = {0,0,0,0,0,0,0},
+struct TextCacheEntry {
+    char         text[TEXT_CACHE_MAX_LEN + 1];
+    SDL_Texture* tex;
+    int          w;          // texture width at scale 1 (height is 5)
+    Uint32       lastFrame;
 };
 
-// Simple method: draw text as SDL_RenderFillRect blocks
-void drawPixelText(SDL_Renderer* rend, const char* text, int x, int y, int scale, Color col) {
-    // Very simple 3x5 pixel font using hardcoded segments
-    setColor(rend, col);
-    // We'll use a simplified approach with just drawing rectangles
-    int ox = x;
-    for (int ci = 0; text[ci] != '\0'; ci++) {
-        char c = text[ci];
-        if (c == ' ') { x += 4*scale; continue; }
-        
-        // Define segments for common chars using 3-wide 5-tall grid
-        // Bit pattern: top, top-left, top-right, mid, bot-left, bot-right, bot
-        // Use 0=off, 1=on for each pixel row
-        uint8_t rows[5] = {0,0,0,0,0};
-        
-        switch(c) {
-            case '0': rows[0]=7; rows[1]=5; rows[2]=5; rows[3]=5; rows[4]=7; break;
-            case '1': rows[0]=3; rows[1]=1; rows[2]=1; rows[3]=1; rows[4]=7; break;
-            case '2': rows[0]=7; rows[1]=1; rows[2]=7; rows[3]=4; rows[4]=7; break;
-            case '3': rows[0]=7; rows[1]=1; rows[2]=7; rows[3]=1; rows[4]=7; break;
-            case '4': rows[0]=5; rows[1]=5; rows[2]=7; rows[3]=1; rows[4]=1; break;
-            case '5': rows[0]=7; rows[1]=4; rows[2]=7; rows[3]=1; rows[4]=7; break;
-            case '6': rows[0]=7; rows[1]=4; rows[2]=7; rows[3]=5; rows[4]=7; break;
-            case '7': rows[0]=7; rows[1]=1; rows[2]=1; rows[3]=1; rows[4]=1; break;
-            case '8': rows[0]=7; rows[1]=5; rows[2]=7; rows[3]=5; rows[4]=7; break;
-            case '9': rows[0]=7; rows[1]=5; rows[2]=7; rows[3]=1; rows[4]=7; break;
-            case 'A': rows[0]=7; rows[1]=5; rows[2]=7; rows[3]=5; rows[4]=5; break;
-            case 'B': rows[0]=6; rows[1]=5; rows[2]=7; rows[3]=5; rows[4]=6; break;
-            case 'C': rows[0]=7; rows[1]=4; rows[2]=4; rows[3]=4; rows[4]=7; break;
-            case 'D': rows[0]=6; rows[1]=5; rows[2]=5; rows[3]=5; rows[4]=6; break;
-            case 'E': rows[0]=7; rows[1]=4; rows[2]=7; rows[3]=4; rows[4]=7; break;
-            case 'F': rows[0]=7; rows[1]=4; rows[2]=7; rows[3]=4; rows[4]=4; break;
-            case 'G': rows[0]=7; rows[1]=4; rows[2]=5; rows[3]=5; rows[4]=7; break;
-            case 'H': rows[0]=5; rows[1]=5; rows[2]=7; rows[3]=5; rows[4]=5; break;
-            case 'I': rows[0]=7; rows[1]=2; rows[2]=2; rows[3]=2; rows[4]=7; break;
-            case 'J': rows[0]=1; rows[1]=1; rows[2]=1; rows[3]=5; rows[4]=7; break;
-            case 'K': rows[0]=5; rows[1]=5; rows[2]=6; rows[3]=5; rows[4]=5; break;
-            case 'L': rows[0]=4; rows[1]=4; rows[2]=4; rows[3]=4; rows[4]=7; break;
-            case 'M': rows[0]=5; rows[1]=7; rows[2]=5; rows[3]=5; rows[4]=5; break;
-            case 'N': rows[0]=5; rows[1]=7; rows[2]=7; rows[3]=5; rows[4]=5; break;
-            case 'O': rows[0]=7; rows[1]=5; rows[2]=5; rows[3]=5; rows[4]=7; break;
-            case 'P': rows[0]=7; rows[1]=5; rows[2]=7; rows[3]=4; rows[4]=4; break;
-            case 'Q': rows[0]=7; rows[1]=5; rows[2]=5; rows[3]=7; rows[4]=1; break;
-            case 'R': rows[0]=7; rows[1]=5; rows[2]=7; rows[3]=5; rows[4]=5; break; // same as A diff
-            case 'S': rows[0]=7; rows[1]=4; rows[2]=7; rows[3]=1; rows[4]=7; break;
-            case 'T': rows[0]=7; rows[1]=2; rows[2]=2; rows[3]=2; rows[4]=2; break;
-            case 'U': rows[0]=5; rows[1]=5; rows[2]=5; rows[3]=5; rows[4]=7; break;
-            case 'V': rows[0]=5; rows[1]=5; rows[2]=5; rows[3]=5; rows[4]=2; break;
-            case 'W': rows[0]=5; rows[1]=5; rows[2]=5; rows[3]=7; rows[4]=5; break;
-            case 'X': rows[0]=5; rows[1]=5; rows[2]=2; rows[3]=5; rows[4]=5; break;
-            case 'Y': rows[0]=5; rows[1]=5; rows[2]=7; rows[3]=2; rows[4]=2; break;
-            case 'Z': rows[0]=7; rows[1]=1; rows[2]=2; rows[3]=4; rows[4]=7; break;
-            case ':': rows[0]=0; rows[1]=2; rows[2]=0; rows[3]=2; rows[4]=0; break;
-            case '-': rows[0]=0; rows[1]=0; rows[2]=7; rows[3]=0; rows[4]=0; break;
-            case '/': rows[0]=1; rows[1]=2; rows[2]=2; rows[3]=4; rows[4]=4; break;
-            case '%': rows[0]=5; rows[1]=1; rows[2]=2; rows[3]=4; rows[4]=5; break;
-            case '!': rows[0]=2; rows[1]=2; rows[2]=2; rows[3]=0; rows[4]=2; break;
-            case '.': rows[0]=0; rows[1]=0; rows[2]=0; rows[3]=0; rows[4]=2; break;
-            case '+': rows[0]=0; rows[1]=2; rows[2]=7; rows[3]=2; rows[4]=0; break;
-            case '*': rows[0]=5; rows[1]=2; rows[2]=7; rows[3]=2; rows[4]=5; break;
-            case '<': rows[0]=1; rows[1]=2; rows[2]=4; rows[3]=2; rows[4]=1; break;
-            case '>': rows[0]=4; rows[1]=2; rows[2]=1; rows[3]=2; rows[4]=4; break;
-            default: x += 4*scale; continue;
-        }
-        
+struct TextCache {
+    SDL_Renderer*  r      = nullptr;   // renderer the textures belong to
+    SDL_Texture*   glyphs = nullptr;   // 128 glyphs, GLYPH_ADVANCE px apart
+    TextCacheEntry slots[TEXT_CACHE_SLOTS] = {};
+    Uint32         frame  = 0;
+    int            createdThisFrame = 0;
+};
+TextCache g_text;
+
+// Rasterizes text at scale 1 into white-on-transparent RGBA pixels
+void rasterizeText(const char* text, int len, Uint32* px, int w) {
+    std::fill(px, px + w * 5, 0u);
+    for (int ci = 0; ci < len; ci++) {
+        const Uint8* rows = glyphRows(text[ci]);
+        for (int row = 0; row < 5; row++)
+            for (int bit = 2; bit >= 0; bit--)
+                if (rows[row] & (1 << bit))
+                    px[row * w + ci * GLYPH_ADVANCE + (2 - bit)] = 0xFFFFFFFFu;
+    }
+}
+
+SDL_Texture* createTextTexture(SDL_Renderer* r, const char* text, int len, int w) {
+    std::vector<Uint32> px((size_t)w * 5);
+    rasterizeText(text, len, px.data(), w);
+    SDL_Texture* tex = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, w, 5);
+    if (!tex) return nullptr;
+    SDL_UpdateTexture(tex, nullptr, px.data(), w * 4);
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(tex, SDL_ScaleModeNearest);
+    return tex;
+}
+
+void destroyTextCache() {
+    TextCache& tc = g_text;
+    for (auto& e : tc.slots) {
+        if (e.tex) SDL_DestroyTexture(e.tex);
+        e = {};
+    }
+    if (tc.glyphs) { SDL_DestroyTexture(tc.glyphs); tc.glyphs = nullptr; }
+    tc.r = nullptr;
+}
+
+void initTextCache(SDL_Renderer* r) {
+    destroyTextCache();
+    char all[128];
+    for (int i = 0; i < 128; i++) all[i] = (char)i;
+    g_text.glyphs = createTextTexture(r, all, 128, 128 * GLYPH_ADVANCE);
+    if (g_text.glyphs) g_text.r = r;
+}
+
+// Once per frame: advances the LRU clock and resets the upload budget
+void beginTextFrame() {
+    g_text.frame++;
+    g_text.createdThisFrame = 0;
+}
+
+const TextCacheEntry* lookupText(const char* text, int len) {
+    TextCache& tc = g_text;
+    if (len > TEXT_CACHE_MAX_LEN) return nullptr;
+    TextCacheEntry* victim = nullptr;
+    for (auto& e : tc.slots) {
+        if (e.tex && strcmp(e.text, text) == 0) { e.lastFrame = tc.frame; return &e; }
+        if (!victim || !e.tex || (victim->tex && e.lastFrame < victim->lastFrame)) victim = &e;
+    }
+    if (tc.createdThisFrame >= TEXT_CACHE_NEW_PER_FRAME) return nullptr;
+    if (victim->tex && victim->lastFrame == tc.frame) return nullptr; // every slot drawn this frame
+    
+    int w = len * GLYPH_ADVANCE;
+    SDL_Texture* tex = createTextTexture(tc.r, text, len, w);
+    if (!tex) return nullptr;
+    if (victim->tex) SDL_DestroyTexture(victim->tex);
+    memcpy(victim->text, text, len + 1);
+    victim->tex = tex;
+    victim->w = w;
+    victim->lastFrame = tc.frame;
+    tc.createdThisFrame++;
+    return victim;
+}
+
+// No cache: one rect per lit pixel. Any renderer, any thread.
+void drawPixelTextRects(SDL_Renderer* rend, const char* text, int x, int y, int scale, Color col) {
+    for (const char* c = text; *c; c++, x += GLYPH_ADVANCE*scale) {
+        const Uint8* rows = glyphRows(*c);
         for (int row = 0; row < 5; row++) {
             for (int bit = 2; bit >= 0; bit--) {
                 if (rows[row] & (1 << bit)) {
                     int bx = x + (2-bit)*scale;
                     int by = y + row*scale;
-                    SDL_Rect px = {bx, by, scale, scale};
-                    SDL_RenderFillRect(rend, &px);
+                    fillRect(rend, bx, by, scale, scale, col);
                 }
             }
         }
-        x += 4*scale;
     }
 }
 
-// ==================== GAME OBJECTS ====================
+void drawPixelText(SDL_Renderer* rend, const char* text, int x, int y, int scale, Color col) {
+    int len = (int)strlen(text);
+    if (len == 0) return;
+    
+    // g_text belongs to the main thread, which rebuilds it on a reset
+    // while the warm-up thread may be baking; other threads never look
+    if (t_traceTid == TRACE_TID_MAIN && rend == g_text.r) {
+        flushPrims(rend);
+        // Whole string in one copy
+        if (const TextCacheEntry* e = lookupText(text, len)) {
+            SDL_SetTextureColorMod(e->tex, col.r, col.g, col.b);
+            SDL_SetTextureAlphaMod(e->tex, col.a);
+            SDL_Rect dst = { x, y, e->w * scale, 5 * scale };
+            SDL_RenderCopy(rend, e->tex, nullptr, &dst);
+            profDrawCall();
+            return;
+        }
+        // One copy per glyph from the atlas
+        SDL_SetTextureColorMod(g_text.glyphs, col.r, col.g, col.b);
+        SDL_SetTextureAlphaMod(g_text.glyphs, col.a);
+        for (int ci = 0; ci < len; ci++, x += GLYPH_ADVANCE*scale) {
+            int c = (unsigned char)text[ci] & 127;
+            if (c == ' ') continue;
+            SDL_Rect src = { c * GLYPH_ADVANCE, 0, 3, 5 };
+            SDL_Rect dst = { x, y, 3 * scale, 5 * scale };
+            SDL_RenderCopy(rend, g_text.glyphs, &src, &dst);
+            profDrawCall();
+        }
+        return;
+    }
+    
+    // No cache for this renderer (e.g. atlas bakes)
+    drawPixelTextRects(rend, text, x, y, scale, col);
+}
 
-struct Bullet {
-    float x, y;
-    float vx, vy;
-    bool active;
-    bool isEnemy;
-    int damage;
-    Color col;
-};
+// ==================== GAME OBJECTS ====================
 
 struct Missile {
     float x, y;
+    float prevX, prevY;   // position at the start of the last sim step
     float vx, vy;
     float targetX, targetY;
     bool active;
@@ -237,72 +967,572 @@ struct Missile {
     float life;
 };
 
-struct Explosion {
-    float x, y;
-    float radius;
-    float maxRadius;
-    float life;
-    float maxLife;
-    Color col;
-};
-
 struct PowerUp {
     float x, y;
+    float prevY;
     float vy;
     bool active;
     int type; // 0=health, 1=shield, 2=rapid, 3=missile, 4=bomb
     float bob;
 };
 
+// Per-type stats (max HP, fire rate, score) come from ARCHETYPES; the
+// type itself is the EnemyStore array the jet lives in
 struct EnemyJet {
     float x, y;
+    float prevX, prevY;
     float vx, vy;
     bool active;
-    int hp, maxHp;
-    int type;       // 0=basic, 1=fast, 2=heavy, 3=boss
+    int hp;
     float shootTimer;
-    float shootInterval;
     float moveTimer;
     float depth;    // 3D depth (z)
-    int score;
+    Uint32 seq;     // spawn order, across all types
+};
+
+// ==================== ENEMY ARCHETYPES ====================
+enum EnemyType { ENEMY_BASIC, ENEMY_FAST, ENEMY_HEAVY, ENEMY_BOSS, ENEMY_TYPES };
+
+struct Archetype {
+    Sint16 hp;
+    Sint16 speedX, speedY;   // speedX starts left or right at random, except bosses
+    float  shootInterval;
+    Uint8  hitR, missileHitR;
+    Sint16 score;
+    Uint8  drawScale;        // thruster size
+    Uint8  deathFx;          // explosion radius on a kill
+    Sint16 shotSpeed;
+    Uint8  shotDamage;
+    Uint8  missileOdds;      // one shot in N also launches a homing missile, 0 never
+    bool   boss;             // spawns centred, own movement, spread fire, HP banner
+};
+
+constexpr Archetype ARCHETYPES[ENEMY_TYPES] = {
+    //  hp  spdX spdY shoot  hitR mHitR score  scale fx  shot dmg msl  boss
+    {   30,  60,  80, 1.5f,  30,  35,   100,  1,   50, 250, 10,  0, false },  // basic
+    {   20, 120, 160, 1.0f,  30,  35,   200,  1,   50, 250, 10,  0, false },  // fast
+    {   80,  40,  60, 0.8f,  30,  35,   500,  2,   50, 250, 10,  3, false },  // heavy
+    {  500, 100,  30, 0.4f,  50,  60,  5000,  1,  120, 350, 20,  0, true  },  // boss
+};
+
+// ==================== ENEMY STORE ====================
+// One array per archetype, each in spawn order, so the per-type kernels
+// (EnemyKernel<T>) run over homogeneous data with the archetype folded in
+// at compile time. Anything whose outcome depends on the order enemies are
+// visited in (rng draws, event order, the state hash) walks them merged by
+// seq with forEachBySpawn, which is the order of the old single list.
+// An EnemyRef packs (type, index) into the int slots of events and the grid.
+struct EnemyStore {
+    std::vector<EnemyJet> of[ENEMY_TYPES];
+    Uint32 nextSeq = 0;
+
+    size_t size() const {
+        size_t n = 0;
+        for (const auto& v : of) n += v.size();
+        return n;
+    }
+    bool empty() const { return size() == 0; }
+    void clear() { for (auto& v : of) v.clear(); }
+};
+
+const int ENEMY_REF_SHIFT = 16;
+inline int enemyRef(int type, int index) { return type << ENEMY_REF_SHIFT | index; }
+inline int refType(int ref)  { return ref >> ENEMY_REF_SHIFT; }
+inline int refIndex(int ref) { return ref & ((1 << ENEMY_REF_SHIFT) - 1); }
+inline EnemyJet& enemyAt(EnemyStore& s, int ref) { return s.of[refType(ref)][refIndex(ref)]; }
+inline const EnemyJet& enemyAt(const EnemyStore& s, int ref) { return s.of[refType(ref)][refIndex(ref)]; }
+
+// Calls fn(ref, e) for every enemy, active or not, in spawn order
+template <typename Store, typename Fn>
+void forEachBySpawn(Store& s, Fn fn) {
+    size_t at[ENEMY_TYPES] = {};
+    for (;;) {
+        int best = -1;
+        for (int t = 0; t < ENEMY_TYPES; t++)
+            if (at[t] < s.of[t].size() &&
+                (best < 0 || s.of[t][at[t]].seq < s.of[best][at[best]].seq)) best = t;
+        if (best < 0) return;
+        fn(enemyRef(best, (int)at[best]), s.of[best][at[best]]);
+        at[best]++;
+    }
+}
+
+// Calls fn(std::integral_constant<int, T>) for each archetype, so a generic
+// lambda can instantiate EnemyKernel<T> per type
+template <typename Fn, int... T>
+void forEachArchetypeImpl(Fn& fn, std::integer_sequence<int, T...>) {
+    (fn(std::integral_constant<int, T>()), ...);
+}
+template <typename Fn>
+void forEachArchetype(Fn fn) {
+    forEachArchetypeImpl(fn, std::make_integer_sequence<int, ENEMY_TYPES>());
+}
+
+// ==================== WAVE SCHEDULE ====================
+// Regular spawns are laid out ahead of time on a tick timeline, a few
+// seconds at a time, and updateGame just walks a cursor along it. The
+// cadence works exactly as the old per-tick timers did; density scales
+// the enemy rate for stress runs. Which archetype an entry becomes is
+// still drawn from the gameplay rng when it spawns, and the boss is
+// state driven (one at a time after bossTime), so neither is scheduled.
+struct WaveRules {
+    float firstInterval;    // seconds between enemies at t = 0
+    float ramp;             // interval shrinks by this per second played
+    float minInterval;
+    float fastUnlock;       // archetypes unlock with game time
+    float heavyUnlock;
+    float bossTime;
+    float powerupInterval;
+};
+constexpr WaveRules WAVE_RULES = { 2.0f, 0.02f, 0.5f, 30, 60, 90, 12 };
+
+enum WaveKind : Uint8 { WAVE_ENEMY, WAVE_POWERUP };
+
+struct WaveEntry {
+    Uint32 tick;    // schedule tick it fires on
+    Uint8  kind;
+    Uint8  types;   // WAVE_ENEMY: archetypes [0, types) are eligible
+};
+
+const int   WAVE_QUEUE   = 64;
+const float WAVE_HORIZON = 4.0f;   // seconds of timeline laid out ahead
+
+struct WaveSchedule {
+    WaveEntry queue[WAVE_QUEUE];
+    int       head = 0, count = 0;
+    Uint32    tick = 0;          // cursor: schedule ticks taken
+    float     density = 1.0f;    // enemy spawn rate multiplier
+    // Generator state, genTick ticks ahead of the start
+    Uint32    genTick = 0;
+    float     genTime = 0;
+    float     enemyTimer = 0;
+    float     powerupTimer = 0;
+};
+
+// ==================== PARALLAX LAYERS ====================
+// The background scrolls as a few prerendered strips that wrap around:
+// the sim only advances one offset per layer, and drawing a layer is a
+// few texture copies however much is baked into it (see DRAW BACKGROUND).
+// A sprinkle of foreground stars still moves on its own so the sky does
+// not read as a repeating tile.
+enum LayerId { LAYER_STARS_FAR, LAYER_STARS_NEAR, LAYER_CLOUDS_FAR, LAYER_CLOUDS_NEAR, LAYER_MOUNTAINS, LAYER_COUNT };
+enum LayerKind : Uint8 { LK_STARS, LK_CLOUDS, LK_MOUNTAINS };
+
+struct ParallaxLayer {
+    LayerKind kind;
+    bool      horizontal;   // scrolls right to left, else top to bottom
+    float     speed;        // px/s
+    int       tileW, tileH; // baked strip; tileW 0 is the screen width
+    int       count;        // stars, clouds or peaks baked in
+    int       sizeMax;      // stars: 1..sizeMax px
+    float     brightMin;    // stars: brightMin..1
+    Uint32    seed;         // layout; render-side, never the sim's streams
 };
 
+const int PARALLAX_TILE_H  = 640;
+const int MOUNTAIN_STRIP_W = 780;   // six peaks, 130 apart
+const int MOUNTAIN_STRIP_H = 250;
+
+const ParallaxLayer PARALLAX[LAYER_COUNT] = {
+    /* LAYER_STARS_FAR   */ { LK_STARS,     false,  70, 0, PARALLAX_TILE_H, 70, 1, 0.3f, 1 },
+    /* LAYER_STARS_NEAR  */ { LK_STARS,     false, 150, 0, PARALLAX_TILE_H, 30, 2, 0.6f, 2 },
+    /* LAYER_CLOUDS_FAR  */ { LK_CLOUDS,    false,  35, 0, PARALLAX_TILE_H,  3, 0, 0,    3 },
+    /* LAYER_CLOUDS_NEAR */ { LK_CLOUDS,    false,  65, 0, PARALLAX_TILE_H,  2, 0, 0,    4 },
+    /* LAYER_MOUNTAINS   */ { LK_MOUNTAINS, true,   20, MOUNTAIN_STRIP_W, MOUNTAIN_STRIP_H, 6, 0, 0, 5 },
+};
+
+inline float layerWrap(const ParallaxLayer& l) { return l.horizontal ? (float)l.tileW : (float)l.tileH; }
+
+const int SPRINKLE_STARS = 12;
+
 struct Star {
     float x, y;
+    float prevY;
     float speed;
     float brightness;
     int size;
 };
 
-struct Cloud {
-    float x, y;
-    float speed;
-    float w, h;
-    int alpha;
+// ==================== OBJECT POOLS ====================
+// Fixed-capacity entity store with a free list. Slots never move, so
+// iteration order is stable across ticks and acquire/release are O(1).
+// Range-for walks slots [0, top) and skips free ones. peak and dropped
+// are the sizing counters reported by logPoolStats.
+template <typename T, int N>
+struct Pool {
+    T    items[N];
+    bool used[N] = {};
+    int  freeList[N];
+    int  freeCount = 0;
+    int  top       = 0;  // slots below this have been handed out
+    int  count     = 0;
+    int  peak      = 0;  // high-water mark of count
+    int  dropped   = 0;  // acquires refused because the pool was full
+
+    T* acquire() {
+        if (count == 0) { top = 0; freeCount = 0; } // keep scans short after a burst
+        int i;
+        if (freeCount > 0)  i = freeList[--freeCount];
+        else if (top < N)   i = top++;
+        else { dropped++; return nullptr; }
+        used[i] = true;
+        if (++count > peak) peak = count;
+        return &items[i];
+    }
+    void release(T* t) {
+        int i = (int)(t - items);
+        if (!used[i]) return;
+        used[i] = false;
+        freeList[freeCount++] = i;
+        count--;
+    }
+    void clear() {
+        for (int i = 0; i < top; i++) used[i] = false;
+        top = freeCount = count = 0;
+    }
+    int  size()  const { return count; }
+    bool empty() const { return count == 0; }
+
+    template <typename P, typename U>
+    struct iter {
+        P* p; int i;
+        U& operator*() const { return p->items[i]; }
+        iter& operator++() { do { i++; } while (i < p->top && !p->used[i]); return *this; }
+        // Compare against the live top so a reset during iteration ends the loop
+        bool operator!=(const iter&) const { return i < p->top; }
+    };
+    using iterator       = iter<Pool, T>;
+    using const_iterator = iter<const Pool, const T>;
+    int firstUsed() const { int i = 0; while (i < top && !used[i]) i++; return i; }
+    iterator       begin()       { return { this, firstUsed() }; }
+    iterator       end()         { return { this, top }; }
+    const_iterator begin() const { return { this, firstUsed() }; }
+    const_iterator end()   const { return { this, top }; }
 };
 
-struct Mountain {
-    float x, h;
-    float speed;
-    Color col;
+const int MAX_BULLETS    = 512;
+const int MAX_MISSILES   = 64;
+const int MAX_POWERUPS   = 32;
+
+// ==================== BULLET STORE (SoA) ====================
+// Bullets are the highest-volume entity, so they live in parallel arrays
+// instead of a Pool of structs: the hot kinematics (x, y, vx, vy) are
+// contiguous for the integration, culling and player hit-test kernels,
+// and the cold fields are only touched on a hit or at draw time. Slot
+// management (free list, top, peak, dropped) mirrors Pool.
+struct BulletStore {
+    alignas(16) float x[MAX_BULLETS];
+    alignas(16) float y[MAX_BULLETS];
+    alignas(16) float vx[MAX_BULLETS];
+    alignas(16) float vy[MAX_BULLETS];
+    alignas(16) float prevX[MAX_BULLETS]; // position before the last integrate
+    alignas(16) float prevY[MAX_BULLETS];
+    Uint8 alive[MAX_BULLETS]   = {};
+    Uint8 isEnemy[MAX_BULLETS] = {};
+    Uint8 dead[MAX_BULLETS];     // per-tick: left the field or hit something
+    Uint8 nearPlayer[MAX_BULLETS]; // per-tick: enemy bullet inside player radius
+    int   damage[MAX_BULLETS];
+    Color col[MAX_BULLETS];
+
+    int freeList[MAX_BULLETS];
+    int freeCount = 0;
+    int top       = 0;
+    int count     = 0;
+    int peak      = 0;
+    int dropped   = 0;
+
+    int acquire() {
+        if (count == 0) { top = 0; freeCount = 0; }
+        int i;
+        if (freeCount > 0)        i = freeList[--freeCount];
+        else if (top < MAX_BULLETS) i = top++;
+        else { dropped++; return -1; }
+        alive[i] = 1;
+        if (++count > peak) peak = count;
+        return i;
+    }
+    void release(int i) {
+        if (!alive[i]) return;
+        alive[i] = 0;
+        vx[i] = vy[i] = 0; // free slots still go through the kernels; keep them parked
+        freeList[freeCount++] = i;
+        count--;
+    }
+    void clear() {
+        for (int i = 0; i < top; i++) { alive[i] = 0; vx[i] = vy[i] = 0; }
+        top = freeCount = count = 0;
+    }
+    int  size()  const { return count; }
+    bool empty() const { return count == 0; }
 };
 
-// ==================== PLAYER ====================
-struct Player {
+// The kernels below run over every slot in [0, top), free or not. That is
+// cheaper than branching on alive and lets the compiler emit NEON/SSE.
+void integrateBullets(BulletStore& bs, float dt) {
+    float* __restrict x  = bs.x;
+    float* __restrict y  = bs.y;
+    float* __restrict px = bs.prevX;
+    float* __restrict py = bs.prevY;
+    const float* __restrict vx = bs.vx;
+    const float* __restrict vy = bs.vy;
+    for (int i = 0, n = bs.top; i < n; i++) {
+        px[i] = x[i];
+        py[i] = y[i];
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+    }
+}
+
+void cullBullets(BulletStore& bs, float minX, float minY, float maxX, float maxY) {
+    const float* __restrict x = bs.x;
+    const float* __restrict y = bs.y;
+    Uint8* __restrict dead = bs.dead;
+    for (int i = 0, n = bs.top; i < n; i++)
+        dead[i] = (Uint8)((x[i] < minX) | (x[i] > maxX) | (y[i] < minY) | (y[i] > maxY));
+}
+
+// Flags enemy bullets within r of (px,py); the caller resolves them in slot order
+void markBulletsNear(BulletStore& bs, float px, float py, float r) {
+    const float* __restrict x = bs.x;
+    const float* __restrict y = bs.y;
+    const Uint8* __restrict enemy = bs.isEnemy;
+    Uint8* __restrict hit = bs.nearPlayer;
+    float r2 = r * r;
+    for (int i = 0, n = bs.top; i < n; i++) {
+        float dx = x[i] - px, dy = y[i] - py;
+        hit[i] = (Uint8)((dx*dx + dy*dy < r2) & enemy[i]);
+    }
+}
+
+// ==================== PARTICLES ====================
+// Explosion effects live in one fixed ring of particles: blasts (a growing
+// disc with a hot core) and sparks flying outward. Emitting writes at the
+// head, so with the ring full the oldest, most faded particle is what gets
+// overwritten. Under load sparks are thinned first, and a blast landing on
+// a fresh one of the same colour grows that one instead of stacking
+// another on top (rapid fire on the boss).
+const int   MAX_PARTICLES      = 1024;
+const int   PARTICLE_RECENT    = 16;     // newest blasts considered for merging
+const float PARTICLE_LIFE      = 0.5f;
+const float PARTICLE_MERGE_AGE = 0.15f;  // blasts younger than this absorb nearby ones
+
+enum ParticleKind : Uint8 { PK_BLAST, PK_SPARK };
+
+struct Particle {
     float x, y;
+    float prevX, prevY;   // position at the start of the last sim step
     float vx, vy;
-    int hp, maxHp;
-    int shield, maxShield;
-    bool shieldActive;
-    float shieldTimer;
-    
-    int score;
-    int lives;
-    int level;
-    int kills;
+    float size, maxSize;  // radius, growing at `growth` px/s up to maxSize
+    float growth;
+    float life, maxLife;  // life <= 0: free slot
+    Color col;
+    Uint8 kind;
+};
+
+struct ParticleRing {
+    Particle items[MAX_PARTICLES] = {};
+    int head    = 0;
+    int live    = 0;
+    int peak    = 0;
+    int dropped = 0;   // live particles overwritten
+    int thinned = 0;   // sparks skipped for load
+    int merged  = 0;   // blasts folded into an earlier one
+    int recent[PARTICLE_RECENT] = {};   // slots of the newest blasts
+    int recentHead = 0;
+};
+
+Particle& emitParticle(ParticleRing& pr) {
+    Particle& pt = pr.items[pr.head];
+    pr.head = (pr.head + 1) % MAX_PARTICLES;
+    if (pt.life > 0) pr.dropped++;
+    else if (++pr.live > pr.peak) pr.peak = pr.live;
+    return pt;
+}
+
+void emitExplosion(ParticleRing& pr, Rng& rng, float x, float y, float sz, Color col) {
+    for (int slot : pr.recent) {
+        Particle& b = pr.items[slot];
+        if (b.kind != PK_BLAST || b.life <= 0 || b.maxLife - b.life > PARTICLE_MERGE_AGE) continue;
+        if (b.col.r != col.r || b.col.g != col.g || b.col.b != col.b) continue;
+        float mr = std::max(b.maxSize, sz) * 0.5f;
+        if (dist2DSq(x, y, b.x, b.y) > mr*mr) continue;
+        b.maxSize = std::max(b.maxSize, sz);
+        b.growth  = b.maxSize / b.maxLife;
+        b.life    = b.maxLife;
+        pr.merged++;
+        return;
+    }
     
-    // Weapons
-    int ammo;         // missiles
+    pr.recent[pr.recentHead] = pr.head;
+    pr.recentHead = (pr.recentHead + 1) % PARTICLE_RECENT;
+    emitParticle(pr) = { x, y, x, y, 0, 0, sz * 0.1f, sz, sz / PARTICLE_LIFE,
+                         PARTICLE_LIFE, PARTICLE_LIFE, col, PK_BLAST };
+    
+    int sparks = sz >= 40 ? 8 : 4;
+    float load = (float)pr.live / MAX_PARTICLES;
+    int keep = load > 0.75f ? 0 : load > 0.5f ? sparks / 2 : sparks;
+    pr.thinned += sparks - keep;
+    float a0 = rng.uniform() * 2 * (float)M_PI;
+    float speed = sz * 1.2f / PARTICLE_LIFE;   // ends at 1.2x the blast radius
+    for (int i = 0; i < keep; i++) {
+        float a = a0 + i * 2 * (float)M_PI / keep;
+        emitParticle(pr) = { x, y, x, y, fcos(a) * speed, fsin(a) * speed, 2, 2, 0,
+                             PARTICLE_LIFE, PARTICLE_LIFE, {255,200,50,255}, PK_SPARK };
+    }
+}
+
+void ageParticles(ParticleRing& pr, float dt) {
+    if (pr.live == 0) return;
+    for (Particle& pt : pr.items) {
+        if (pt.life <= 0) continue;
+        pt.prevX = pt.x; pt.prevY = pt.y;
+        pt.life -= dt;
+        if (pt.life <= 0) { pr.live--; continue; }
+        pt.x += pt.vx * dt;
+        pt.y += pt.vy * dt;
+        pt.size = std::min(pt.maxSize, pt.size + pt.growth * dt);
+    }
+}
+
+void clearParticles(ParticleRing& pr) {
+    for (Particle& pt : pr.items) pt.life = 0;
+    pr.live = 0;
+}
+
+// ==================== SPATIAL GRID ====================
+// Uniform-grid broadphase over the play field. Rebuilt once per tick from
+// the enemy store (counting sort, no per-tick allocation once warmed up) and
+// queried by the bullet/missile hit tests and the homing target search.
+// Items are spawn-order ranks, so sorting them is spawn order; refs maps a
+// rank back to its EnemyRef. Positions outside the field are clamped into
+// the border cells.
+const int GRID_CELL     = 80;  // px, >= the largest enemy hit radius
+const int GRID_MAX_HITR = 60;  // largest hit radius any query must cover
+
+struct SpatialGrid {
+    int cols = 0, rows = 0;
+    std::vector<int> cellStart;  // cols*rows+1 prefix offsets into items
+    std::vector<int> items;      // enemy ranks grouped by cell
+    std::vector<int> refs;       // per rank: EnemyRef
+    std::vector<int> cellOf;     // per rank: cell index, -1 if inactive
+    std::vector<int> cursor;     // scratch for the scatter pass
+    std::vector<int> found;      // scratch for query results
+};
+
+void initGrid(SpatialGrid& gr) {
+    gr.cols = (SCREEN_W + GRID_CELL - 1) / GRID_CELL;
+    gr.rows = (PLAY_H + GRID_CELL - 1) / GRID_CELL;
+    gr.cellStart.assign(gr.cols * gr.rows + 1, 0);
+    gr.cursor.assign(gr.cols * gr.rows, 0);
+    gr.items.reserve(64);
+    gr.refs.reserve(64);
+    gr.cellOf.reserve(64);
+    gr.found.reserve(64);
+}
+
+inline int gridCol(const SpatialGrid& gr, float x) {
+    int c = (int)floorf(x / GRID_CELL);
+    return c < 0 ? 0 : c >= gr.cols ? gr.cols-1 : c;
+}
+inline int gridRow(const SpatialGrid& gr, float y) {
+    int r = (int)floorf(y / GRID_CELL);
+    return r < 0 ? 0 : r >= gr.rows ? gr.rows-1 : r;
+}
+
+void buildGrid(SpatialGrid& gr, const EnemyStore& enemies) {
+    int cells = gr.cols * gr.rows;
+    std::fill(gr.cellStart.begin(), gr.cellStart.end(), 0);
+    gr.refs.clear();
+    gr.cellOf.clear();
+
+    int count = 0;
+    forEachBySpawn(enemies, [&](int ref, const EnemyJet& e) {
+        gr.refs.push_back(ref);
+        if (!e.active) { gr.cellOf.push_back(-1); return; }
+        int c = gridRow(gr, e.y) * gr.cols + gridCol(gr, e.x);
+        gr.cellOf.push_back(c);
+        gr.cellStart[c+1]++;
+        count++;
+    });
+    int n = (int)gr.refs.size();
+    for (int c = 0; c < cells; c++) {
+        gr.cellStart[c+1] += gr.cellStart[c];
+        gr.cursor[c] = gr.cellStart[c];
+    }
+    gr.items.resize(count);
+    for (int i = 0; i < n; i++)
+        if (gr.cellOf[i] >= 0) gr.items[gr.cursor[gr.cellOf[i]]++] = i;
+}
+
+// Ranks of all enemies whose cell overlaps the circle (x,y,r), in spawn
+// order so hit resolution matches a plain linear scan.
+const std::vector<int>& queryGrid(SpatialGrid& gr, float x, float y, float r) {
+    gr.found.clear();
+    int c0 = gridCol(gr, x - r), c1 = gridCol(gr, x + r);
+    int r0 = gridRow(gr, y - r), r1 = gridRow(gr, y + r);
+    for (int row = r0; row <= r1; row++) {
+        for (int col = c0; col <= c1; col++) {
+            int c = row * gr.cols + col;
+            for (int k = gr.cellStart[c]; k < gr.cellStart[c+1]; k++)
+                gr.found.push_back(gr.items[k]);
+        }
+    }
+    if (gr.found.size() > 1) std::sort(gr.found.begin(), gr.found.end());
+    return gr.found;
+}
+
+// Rank of the nearest active enemy to (x,y), or -1. Walks square rings of
+// cells outward and stops once no unvisited ring can hold anything closer.
+int nearestInGrid(const SpatialGrid& gr, const EnemyStore& enemies, float x, float y) {
+    if (gr.items.empty()) return -1;
+    int cc = gridCol(gr, x), cr = gridRow(gr, y);
+    int maxRing = std::max(gr.cols, gr.rows);
+    int best = -1;
+    float bestD2 = 0;
+    for (int ring = 0; ring <= maxRing; ring++) {
+        for (int row = cr - ring; row <= cr + ring; row++) {
+            if (row < 0 || row >= gr.rows) continue;
+            bool edgeRow = (row == cr - ring || row == cr + ring);
+            int step = edgeRow ? 1 : 2 * ring;
+            for (int col = cc - ring; col <= cc + ring; col += (step > 0 ? step : 1)) {
+                if (col < 0 || col >= gr.cols) continue;
+                int c = row * gr.cols + col;
+                for (int k = gr.cellStart[c]; k < gr.cellStart[c+1]; k++) {
+                    int i = gr.items[k];
+                    const EnemyJet& e = enemyAt(enemies, gr.refs[i]);
+                    if (!e.active) continue;
+                    float dx = e.x - x, dy = e.y - y;
+                    float d2 = dx*dx + dy*dy;
+                    if (best < 0 || d2 < bestD2 || (d2 == bestD2 && i < best)) {
+                        best = i; bestD2 = d2;
+                    }
+                }
+            }
+        }
+        // Anything in ring+1 or beyond is at least ring*GRID_CELL away
+        float bound = (float)(ring * GRID_CELL);
+        if (best >= 0 && bestD2 < bound * bound) break;
+    }
+    return best;
+}
+
+// ==================== PLAYER ====================
+struct Player {
+    float x, y;
+    float prevX, prevY;
+    float vx, vy;
+    int hp, maxHp;
+    int shield, maxShield;
+    bool shieldActive;
+    float shieldTimer;
+    
+    int score;
+    int lives;
+    int level;
+    int kills;
+    
+    // Weapons
+    int ammo;         // missiles
     int bombs;
     bool rapidFire;
     float rapidTimer;
@@ -323,32 +1553,262 @@ struct Player {
     float tiltX, tiltY; // -1 to 1
 };
 
+// ==================== SPRITE ATLAS ====================
+// Jets, powerups and the explosion disc are rasterized once into a single
+// atlas texture (buildAtlas, in RENDER CACHES) and drawn with SDL_RenderCopy.
+// Only the animated bits (thruster flames, wing-tip lights, spinners, HP
+// bars) are still drawn as primitives.
+const int PLAYER_TILT_STEPS = 5;   // tilt buckets: (int)(tiltX*5) in -5..5
+const int ATLAS_W = 1024;
+const int ATLAS_H = 512;
+const int CIRCLE_SPRITE_R = 64;    // explosion disc, scaled at draw time
+
+enum SpriteId {
+    SPR_PLAYER,                                    // + tilt + PLAYER_TILT_STEPS
+    SPR_ENEMY_BASIC = SPR_PLAYER + 2*PLAYER_TILT_STEPS + 1,
+    SPR_ENEMY_FAST,
+    SPR_ENEMY_HEAVY,
+    SPR_BOSS,
+    SPR_POWERUP,                                   // + powerup type
+    SPR_CIRCLE = SPR_POWERUP + 5,
+    SPR_COUNT
+};
+
+struct Sprite {
+    SDL_Rect src;   // w == 0 if it did not fit / was not baked
+    int ax, ay;     // anchor (entity centre) inside src
+};
+
+struct SpriteAtlas {
+    SDL_Texture* tex = nullptr;
+    Sprite spr[SPR_COUNT] = {};
+};
+
+// Returns false when the sprite is unavailable so callers can fall back
+// to drawing primitives
+bool drawSprite(SDL_Renderer* r, const SpriteAtlas* atlas, int id, int cx, int cy) {
+    if (!atlas || !atlas->tex || atlas->spr[id].src.w == 0) return false;
+    const Sprite& s = atlas->spr[id];
+    SDL_Rect dst = { cx - s.ax, cy - s.ay, s.src.w, s.src.h };
+    renderCopy(r, atlas->tex, &s.src, &dst);
+    return true;
+}
+
+// ==================== SOUND CUES ====================
+// The sim never touches the mixer: it cues sounds into this ring and the
+// main thread plays them once per frame (see AUDIO), folding repeats of
+// the same sound into one voice. Disabled (cues are no-ops) until audio
+// opens, so the headless bench and muted runs pay nothing.
+enum SoundId : Uint8 {
+    SFX_SHOT,
+    SFX_MISSILE,
+    SFX_HIT,
+    SFX_EXPLOSION,
+    SFX_BIG_EXPLOSION,
+    SFX_BOMB,
+    SFX_BOSS,
+    SFX_POWERUP,
+    SFX_PLAYER_HIT,
+    SFX_COUNT
+};
+
+struct SoundCue {
+    Uint8  id;
+    Sint16 x;      // for panning
+};
+
+const int SOUND_QUEUE_SIZE = 256; // power of two
+
+// Single producer (the sim thread) / single consumer (the main thread);
+// full drops the cue
+struct SoundQueue {
+    SoundCue            items[SOUND_QUEUE_SIZE];
+    std::atomic<Uint32> head{0};
+    std::atomic<Uint32> tail{0};
+    std::atomic<bool>   enabled{false};
+    int                 dropped = 0;
+    
+    void push(const SoundCue& c) {
+        Uint32 t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == SOUND_QUEUE_SIZE) { dropped++; return; }
+        items[t & (SOUND_QUEUE_SIZE - 1)] = c;
+        tail.store(t + 1, std::memory_order_release);
+    }
+    bool pop(SoundCue& c) {
+        Uint32 h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        c = items[h & (SOUND_QUEUE_SIZE - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+SoundQueue g_soundQueue;
+
+inline void cueSound(Uint8 id, float x) {
+    if (g_soundQueue.enabled) g_soundQueue.push({ id, (Sint16)x });
+}
+
 // ==================== GAME STATE ====================
-struct Game {
-    SDL_Window*   window   = nullptr;
-    SDL_Renderer* renderer = nullptr;
-    
+// Player input, applied at tick boundaries (see HANDLE INPUT) and
+// optionally recorded or replayed (see INPUT RECORDING). The values are
+// the recording format, so new types go at the end.
+enum InputType : Uint8 {
+    IN_TOUCH,    // v1-2 recordings: any down or drag at (x, y), one finger
+    IN_RELEASE,  // v1-2 recordings
+    IN_SHOOT,
+    IN_MISSILE,
+    IN_BOMB,
+    IN_PAUSE,    // toggle
+    IN_END,      // end of a recording
+    IN_FINGER_DOWN,  // `finger` down at (x, y)
+    IN_FINGER_MOVE,  // `finger` now at (x, y)
+    IN_FINGER_UP,
+    IN_COUNT
+};
+
+struct InputEvent {
+    Uint32 tick;
+    Uint8  type;
+    Sint16 x, y;
+    Uint8  finger;   // IN_FINGER_*: slot, 0 .. MAX_TOUCH_FINGERS-1
+};
+
+// Each finger gets a role on its down event that its moves and lift keep,
+// so one finger can steer while another holds FIRE or taps the buttons
+const int MAX_TOUCH_FINGERS = 4;
+
+enum TouchRole : Uint8 { ROLE_NONE, ROLE_STEER, ROLE_FIRE };
+
+// Single-producer/single-consumer ring from the event loop to whichever
+// thread runs the sim. Full means input is dropped (and counted).
+const int INPUT_QUEUE_SIZE = 256; // power of two
+
+struct InputQueue {
+    InputEvent            items[INPUT_QUEUE_SIZE];
+    std::atomic<Uint32>   head{0};   // written by the consumer
+    std::atomic<Uint32>   tail{0};   // written by the producer
+    int                   dropped = 0;
+    
+    void push(const InputEvent& in) {
+        Uint32 t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == INPUT_QUEUE_SIZE) { dropped++; return; }
+        items[t & (INPUT_QUEUE_SIZE - 1)] = in;
+        tail.store(t + 1, std::memory_order_release);
+    }
+    bool pop(InputEvent& in) {
+        Uint32 h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        in = items[h & (INPUT_QUEUE_SIZE - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Event-loop side of touch: which SDL finger is in which slot, and its
+// latest sample. Motion only updates this; flushTouches queues one move
+// per finger per frame, optionally led along the finger's velocity.
+struct FingerTrack {
+    bool         down   = false;
+    SDL_FingerID id     = 0;
+    float        x = 0, y = 0;     // latest sample
+    float        vx = 0, vy = 0;   // px per ms, smoothed
+    Uint32       t      = 0;       // latest sample's timestamp (ms)
+    bool         moved  = false;   // sampled since the last flush
+    int          sentX = 0, sentY = 0;
+};
+
+struct TouchTracker {
+    FingerTrack fingers[MAX_TOUCH_FINGERS];
+    int         predictMs = 16;   // --touch-predict MS, 0 = off
+    int         coalesced = 0;    // motion samples folded into a later one
+};
+
+struct InputLog {
+    SDL_RWops* rw = nullptr;
+    bool       replaying = false;
+    bool       ended     = false;   // replay hit IN_END (or a truncated file)
+    Uint32     lastTick  = 0;
+    InputEvent next      = {};      // replay lookahead
+};
+
+// Consequences of collisions, queued while the entity loops run and
+// applied afterwards by resolveEvents (see GAME EVENTS)
+enum EventType : Uint8 {
+    EV_HIT,             // source hits enemy `target` for `amount`
+    EV_KILL,            // enemy `target` destroyed by source
+    EV_PLAYER_DAMAGED,  // source hits jet `target` (0 player, 1 wingman) for `amount`
+    EV_SPAWN_EXPLOSION, // at x, y with radius `size`
+    EV_SPAWN_POWERUP,   // at x, y
+};
+
+enum HitSource : Uint8 { SRC_BULLET, SRC_MISSILE, SRC_BOMB, SRC_COUNT };
+
+struct GameEvent {
+    Uint8 type;
+    Uint8 source;      // HitSource
+    int   target;      // EnemyRef, or the jet for EV_PLAYER_DAMAGED
+    int   slot;        // bullet slot / missile pool index to consume on a hit
+    int   amount;
+    float x, y, size;
+    Color col;
+};
+
+// Everything the HUD panel shows. The panel texture is redrawn only when
+// this differs from what it was last drawn with. All ints so it compares
+// with memcmp.
+struct HudState {
+    int hp, maxHp, shield, maxShield;
+    int score, level, lives, ammo, bombs;
+    int combo;      // 0 unless a combo is showing
+    int rapidFire;
+    int wingHp;     // -1 without a wingman in play
+    int wingMaxHp;
+};
+
+// Co-op traffic, kept by the net session on the sim side and published to
+// the renderer with the world. Totals are per second, refreshed each second.
+struct NetStats {
+    int  bytesOut = 0, bytesIn = 0;  // last full second
+    int  maxSnapshot = 0;            // largest snapshot in it
+    int  deferred = 0;               // records pushed to a later snapshot in it
+    int  snapshots = 0;
+    char line[48] = "";              // profiler overlay line
+};
+
+// Simulation state: everything updateGame reads or writes. It holds no
+// SDL handles, so the sim runs without a window (see HEADLESS BENCH).
+struct World {
     GameState state = STATE_MENU;
     Player player;
     
-    std::vector<Bullet>    bullets;
-    std::vector<Missile>   missiles;
-    std::vector<Explosion> explosions;
-    std::vector<PowerUp>   powerups;
-    std::vector<EnemyJet>  enemies;
-    std::vector<Star>      stars;
-    std::vector<Cloud>     clouds;
-    std::vector<Mountain>  mountains;
+    BulletStore                     bullets;
+    Pool<Missile,   MAX_MISSILES>   missiles;
+    ParticleRing                    particles;
+    Pool<PowerUp,   MAX_POWERUPS>   powerups;
+    EnemyStore             enemies;
+    std::vector<int>       shooters; // EnemyRefs firing this tick, scratch
+    std::vector<GameEvent> events;  // empty between ticks
+    std::vector<Star>      stars;      // sprinkle (see PARALLAX LAYERS)
+    float layerScroll[LAYER_COUNT] = {};
+    float layerPrev[LAYER_COUNT]   = {};
+    
+    // Broadphase over enemies, rebuilt each tick
+    SpatialGrid enemyGrid;
+    
+    // Random streams (see RANDOM)
+    Rng rng;    // gameplay: spawns, drops, enemy behaviour
+    Rng fxRng;  // sim-side cosmetics: background layout and respawns
     
     // Timing
-    Uint32 lastTime = 0;
-    float  dt       = 0;
-    float  gameTime = 0;
-    
-    // Spawning
-    float enemySpawnTimer  = 0;
-    float enemySpawnInterval = 2.0f;
-    float powerupSpawnTimer  = 0;
+    Uint32 tick        = 0;  // sim steps taken; input is stamped with it
+    float  dt          = 0;  // sim step, always SIM_DT inside updateGame
+    float  simAccum    = 0;  // real time not yet simulated (see FIXED TIMESTEP)
+    float  renderAlpha = 0;  // how far rendering is between the last two steps
+    float  gameTime    = 0;
+    
+    // Spawning (see WAVE SCHEDULE)
+    WaveSchedule waves;
     float cloudTimer         = 0;
     float mountainTimer      = 0;
     float bossSpawnTimer     = 0;
@@ -359,7 +1819,6 @@ struct Game {
     float bgScrollY = 0;
     
     // UI
-    float menuAnim = 0;
     float gameoverTimer = 0;
     
     // Combo
@@ -372,20 +1831,84 @@ struct Game {
     float shakeAmt     = 0;
     
     // Touch
-    int touchX = SCREEN_W/2;
-    int touchY = PLAY_H/2;
+    int   touchX = SCREEN_W/2;
+    int   touchY = PLAY_H/2;
+    Uint8 fingerRole[MAX_TOUCH_FINGERS] = {};
+    
+    // Co-op (see NET SESSION): a second jet, flown by the remote player.
+    // Score, kills and level are the team's and stay on `player`; a jet
+    // with no lives left is out, and the run ends when both are
+    bool   coop = false;
+    Player wingman;
+    int    wingTouchX = SCREEN_W/2;
+    int    wingTouchY = PLAY_H/2;
+    bool   wingFire   = false;   // holding FIRE
+    NetStats netStats;
+};
+
+inline bool jetInPlay(const World& g, const Player& p) {
+    return &p == &g.player ? (!g.coop || p.lives > 0) : (g.coop && p.lives > 0);
+}
+inline Player& playerAt(World& g, int i) { return i == 1 ? g.wingman : g.player; }
+inline const Player* wingmanInPlay(const World& g) { return jetInPlay(g, g.wingman) ? &g.wingman : nullptr; }
+
+// The jet enemies aim at: the nearest one still flying
+const Player& aimTarget(const World& g, float x, float y) {
+    if (!g.coop || !jetInPlay(g, g.wingman)) return g.player;
+    if (!jetInPlay(g, g.player)) return g.wingman;
+    return dist2DSq(x, y, g.wingman.x, g.wingman.y) < dist2DSq(x, y, g.player.x, g.player.y)
+         ? g.wingman : g.player;
+}
+
+bool fingerHeld(const World& g, Uint8 role) {
+    for (Uint8 r : g.fingerRole) if (r == role) return true;
+    return false;
+}
+
+// The running app: the world plus the window, renderer and render caches
+struct NetSession;
+
+struct Game : World {
+    SDL_Window*   window   = nullptr;
+    SDL_Renderer* renderer = nullptr;
     
-    // Buttons (HUD)
-    SDL_Rect btnFire;
-    SDL_Rect btnMissile;
-    SDL_Rect btnBomb;
-    SDL_Rect btnPause;
+    // Prebaked render layers (see RENDER CACHES)
+    SDL_Texture* bgTex       = nullptr;
+    SDL_Texture* layerTex[LAYER_COUNT] = {};   // parallax strips, baked at bgScale
+    SDL_Texture* playTex     = nullptr;   // low-res play field (ensurePlayTarget)
+    SDL_Texture* pauseTex    = nullptr;   // the frozen game under the pause overlay
+    bool         pauseValid  = false;
+    float        playTexScale = 0;
+    float        bgScale     = 0;     // quality tier bgTex was last queued at
+    SpriteAtlas  atlas;
+    bool         cachesDirty = true;
+    int          cacheLogicalW = 0, cacheLogicalH = 0;
+    SDL_Texture* hudTex      = nullptr;  // render target for the HUD panel
+    HudState     hudDrawn    = {};
+    bool         hudValid    = false;
+    
+    // Frame timing (see FIXED TIMESTEP)
+    Uint64 lastCounter = 0;
+    
+    // UI
+    float menuAnim = 0;
+    Rng   renderRng;  // render-only jitter (screen shake), never touches the sim
+    
+    // Input (see HANDLE INPUT / INPUT RECORDING). The queue is filled by
+    // the event loop; everything else belongs to the thread running the sim.
+    InputQueue              inputQueue;
+    TouchTracker            touch;         // event loop only
+    std::vector<InputEvent> pendingInput;
+    InputLog                inputLog;
+    std::atomic<bool>       quitRequested{false};  // set by the sim (replay end, host lost)
+    NetSession*             net = nullptr;         // --host / --join (see NET SESSION)
 };
 
 // ==================== INIT ====================
 void initPlayer(Player& p) {
     p.x = SCREEN_W / 2.0f;
     p.y = PLAY_H - 200.0f;
+    p.prevX = p.x; p.prevY = p.y;
     p.vx = p.vy = 0;
     p.hp = p.maxHp = 100;
     p.shield = p.maxShield = 50;
@@ -407,170 +1930,313 @@ void initPlayer(Player& p) {
     p.tiltX = p.tiltY = 0;
 }
 
-void initStars(std::vector<Star>& stars) {
+// The second jet starts off to the right of the first
+void initWingman(Player& p) {
+    initPlayer(p);
+    p.x = p.prevX = SCREEN_W * 0.7f;
+}
+
+// A wingman joins the run in progress, or the next one from the menu
+void startCoop(World& w) {
+    w.coop = true;
+    initWingman(w.wingman);
+    w.wingTouchX = (int)w.wingman.x;
+    w.wingTouchY = (int)w.wingman.y;
+    w.wingFire = false;
+}
+
+void initStars(std::vector<Star>& stars, Rng& rng) {
     stars.clear();
-    for (int i = 0; i < 150; i++) {
+    for (int i = 0; i < SPRINKLE_STARS; i++) {
         Star s;
-        s.x = (float)(rand() % SCREEN_W);
-        s.y = (float)(rand() % PLAY_H);
-        s.speed = 50.0f + rand() % 150;
-        s.brightness = 0.3f + (rand() % 70) / 100.0f;
-        s.size = 1 + rand() % 3;
+        s.x = (float)rng.below(SCREEN_W);
+        s.y = s.prevY = (float)rng.below(PLAY_H);
+        s.speed = 220.0f + rng.below(160);
+        s.brightness = 0.8f + rng.below(20) / 100.0f;
+        s.size = 2 + rng.below(2);
         stars.push_back(s);
     }
 }
 
-void initClouds(std::vector<Cloud>& clouds) {
-    clouds.clear();
-    for (int i = 0; i < 8; i++) {
-        Cloud c;
-        c.x = (float)(rand() % SCREEN_W);
-        c.y = (float)(rand() % PLAY_H);
-        c.speed = 30.0f + rand() % 50;
-        c.w = 80.0f + rand() % 120;
-        c.h = 30.0f + rand() % 40;
-        c.alpha = 40 + rand() % 60;
-        clouds.push_back(c);
-    }
+void initWorld(World& w, Uint64 seed) {
+    w.rng.seed(seed, RNG_GAMEPLAY);
+    w.fxRng.seed(seed, RNG_COSMETIC);
+    initPlayer(w.player);
+    initWingman(w.wingman);
+    initStars(w.stars, w.fxRng);
+    initGrid(w.enemyGrid);
+    w.events.reserve(256);
+    for (auto& v : w.enemies.of) v.reserve(32);
+    w.shooters.reserve(64);
 }
 
-void initMountains(std::vector<Mountain>& mountains) {
-    mountains.clear();
-    for (int i = 0; i < 6; i++) {
-        Mountain m;
-        m.x = (float)(i * 130);
-        m.h = 100.0f + rand() % 150;
-        m.speed = 20.0f;
-        m.col = { (Uint8)(20 + rand()%30), (Uint8)(60 + rand()%40), (Uint8)(20 + rand()%20), 255 };
-        mountains.push_back(m);
-    }
+// Pool high-water marks, used to size MAX_* per device tier
+void logPoolStats(const World& g) {
+    SDL_Log("Pool peak/cap (dropped): bullets %d/%d (%d), missiles %d/%d (%d), "
+            "particles %d/%d (%d, %d merged), powerups %d/%d (%d)",
+            g.bullets.peak,    MAX_BULLETS,    g.bullets.dropped,
+            g.missiles.peak,   MAX_MISSILES,   g.missiles.dropped,
+            g.particles.peak,  MAX_PARTICLES,  g.particles.dropped, g.particles.merged,
+            g.powerups.peak,   MAX_POWERUPS,   g.powerups.dropped);
 }
 
-Game* g_game = nullptr;
-
 // ==================== SPAWN FUNCTIONS ====================
-void spawnExplosion(Game& g, float x, float y, float sz, Color col) {
-    Explosion e;
-    e.x = x; e.y = y;
-    e.radius = sz * 0.1f;
-    e.maxRadius = sz;
-    e.life = e.maxLife = 0.5f;
-    e.col = col;
-    g.explosions.push_back(e);
-    // Screen shake
+void spawnExplosion(World& g, float x, float y, float sz, Color col) {
     g.shakeTimer = 0.2f;
     g.shakeAmt = sz * 0.5f;
+    emitExplosion(g.particles, g.fxRng, x, y, sz, col);
 }
 
-void spawnBullet(Game& g, float x, float y, float vx, float vy, bool isEnemy, Color col, int dmg=10) {
-    Bullet b;
-    b.x = x; b.y = y;
-    b.vx = vx; b.vy = vy;
-    b.active = true;
-    b.isEnemy = isEnemy;
-    b.damage = dmg;
-    b.col = col;
-    g.bullets.push_back(b);
+void spawnBullet(World& g, float x, float y, float vx, float vy, bool isEnemy, Color col, int dmg=10) {
+    BulletStore& bs = g.bullets;
+    int i = bs.acquire();
+    if (i < 0) return;
+    bs.x[i] = bs.prevX[i] = x;
+    bs.y[i] = bs.prevY[i] = y;
+    bs.vx[i] = vx; bs.vy[i] = vy;
+    bs.isEnemy[i] = isEnemy;
+    bs.damage[i] = dmg;
+    bs.col[i] = col;
 }
 
-void spawnMissile(Game& g, float x, float y, float tx, float ty, bool isEnemy, int dmg=30) {
-    Missile m;
-    m.x = x; m.y = y;
+void spawnMissile(World& g, float x, float y, float tx, float ty, bool isEnemy, int dmg=30) {
+    Missile* mp = g.missiles.acquire();
+    if (!mp) return;
+    Missile& m = *mp;
+    m.x = m.prevX = x;
+    m.y = m.prevY = y;
     m.targetX = tx; m.targetY = ty;
     float dx = tx - x, dy = ty - y;
-    float len = sqrtf(dx*dx + dy*dy);
-    if (len > 0) { dx /= len; dy /= len; }
+    fnormalize(dx, dy);
     m.vx = dx * 400.0f;
     m.vy = dy * 400.0f;
     m.active = true;
     m.isEnemy = isEnemy;
     m.damage = dmg;
     m.life = 3.0f;
-    g.missiles.push_back(m);
 }
 
-void spawnPowerup(Game& g, float x, float y) {
-    PowerUp p;
-    p.x = x; p.y = y;
+void spawnPowerup(World& g, float x, float y) {
+    PowerUp* pp = g.powerups.acquire();
+    if (!pp) return;
+    PowerUp& p = *pp;
+    p.x = x;
+    p.y = p.prevY = y;
     p.vy = 80.0f;
     p.active = true;
-    p.type = rand() % 5;
+    p.type = g.rng.below(5);
     p.bob = 0;
-    g.powerups.push_back(p);
 }
 
-void spawnEnemy(Game& g, int type) {
+void spawnEnemy(World& g, int type) {
     EnemyJet e;
-    e.x = 60.0f + rand() % (SCREEN_W - 120);
+    e.x = 60.0f + g.rng.below(SCREEN_W - 120);
     e.y = -80.0f;
     e.active = true;
     e.moveTimer = 0;
-    e.depth = 5.0f + rand() % 10;
-    
-    switch(type) {
-        case 0: // basic
-            e.hp = e.maxHp = 30;
-            e.vx = (rand()%2 ? 60.0f : -60.0f);
-            e.vy = 80.0f;
-            e.shootInterval = 1.5f;
-            e.score = 100;
+    e.depth = 5.0f + g.rng.below(10);
+    
+    const Archetype& a = ARCHETYPES[type];
+    e.hp = a.hp;
+    e.vx = a.speedX;
+    if (a.boss) e.x = SCREEN_W / 2.0f;
+    else if (!g.rng.below(2)) e.vx = -e.vx;
+    e.vy = a.speedY;
+    e.shootTimer = a.shootInterval;
+    e.prevX = e.x; e.prevY = e.y;
+    e.seq = g.enemies.nextSeq++;
+    g.enemies.of[type].push_back(e);
+}
+
+// ==================== WAVE SCHEDULER ====================
+// Restarts the timeline from the world's current game time
+void resetWaves(World& g) {
+    WaveSchedule& ws = g.waves;
+    ws.head = ws.count = 0;
+    ws.tick = ws.genTick = 0;
+    ws.genTime = g.gameTime;
+    ws.enemyTimer = ws.powerupTimer = 0;
+}
+
+void pushWave(WaveSchedule& ws, Uint8 kind, Uint8 types) {
+    ws.queue[(ws.head + ws.count++) % WAVE_QUEUE] = { ws.genTick, kind, types };
+}
+
+// Lays out the timeline up to the horizon (or until the queue is full),
+// one sim step at a time in the same arithmetic updateGame uses
+void scheduleWaves(WaveSchedule& ws, float dt) {
+    const WaveRules& r = WAVE_RULES;
+    Uint32 horizon = ws.tick + (Uint32)(WAVE_HORIZON / dt);
+    while (ws.genTick < horizon && ws.count + 2 <= WAVE_QUEUE) {
+        ws.genTime += dt;
+        ws.enemyTimer += dt;
+        float interval = std::max(r.minInterval, r.firstInterval - ws.genTime * r.ramp) / ws.density;
+        if (ws.enemyTimer >= interval) {
+            ws.enemyTimer = 0;
+            Uint8 types = ws.genTime > r.heavyUnlock ? 3 : ws.genTime > r.fastUnlock ? 2 : 1;
+            pushWave(ws, WAVE_ENEMY, types);
+        }
+        ws.powerupTimer += dt;
+        if (ws.powerupTimer > r.powerupInterval) {
+            ws.powerupTimer = 0;
+            pushWave(ws, WAVE_POWERUP, 0);
+        }
+        ws.genTick++;
+    }
+}
+
+// Spawns what is due this step: scheduled enemies, then the boss, then
+// scheduled powerups
+void runWaves(World& g) {
+    WaveSchedule& ws = g.waves;
+    scheduleWaves(ws, g.dt);
+    bool bossChecked = false;
+    auto checkBoss = [&]() {
+        if (bossChecked) return;
+        bossChecked = true;
+        if (g.gameTime > WAVE_RULES.bossTime && !g.bossAlive) {
+            g.bossAlive = true;
+            spawnEnemy(g, ENEMY_BOSS);
+            cueSound(SFX_BOSS, SCREEN_W/2);
+        }
+    };
+    while (ws.count > 0 && ws.queue[ws.head].tick == ws.tick) {
+        WaveEntry we = ws.queue[ws.head];
+        ws.head = (ws.head + 1) % WAVE_QUEUE;
+        ws.count--;
+        if (we.kind == WAVE_ENEMY) {
+            int type = we.types > 1 ? (int)g.rng.below(we.types) : ENEMY_BASIC;
+            if (!g.bossAlive) spawnEnemy(g, type);
+        } else {
+            checkBoss();
+            spawnPowerup(g, 60 + g.rng.below(SCREEN_W-120), -50);
+        }
+    }
+    checkBoss();
+    ws.tick++;
+}
+
+// ==================== GAME EVENTS ====================
+// The bullet and missile loops and bombs only detect; everything a hit
+// changes (hp, score, combo, lives, spawns) happens here, in queue order.
+// Hits re-check their target, so the second of two hits on an enemy the
+// first one killed is void, and the same for hits during invulnerability.
+struct HitRule {
+    float hitFx;        // explosion radius where an enemy hit lands
+    int   killScoreMul; // 0: the combo multiplier, 1 + combo/5
+    bool  countsCombo;
+    int   dropOdds;     // one kill in N drops a powerup, 0 never
+    float playerFx;     // explosion radius on a player hit
+    float playerInv;    // invulnerability after a player hit
+    bool  shieldable;
+};
+
+const HitRule HIT_RULES[SRC_COUNT] = {
+    /* SRC_BULLET  */ { 20, 0, true,  3, 25, 0.5f, true  },
+    /* SRC_MISSILE */ { 60, 2, false, 2, 60, 1.0f, false },
+    /* SRC_BOMB    */ { 60, 1, true,  0,  0, 0.0f, false },
+};
+
+void queueEvent(World& g, Uint8 type, Uint8 source, int target, int slot, int amount, float x, float y) {
+    g.events.push_back({ type, source, target, slot, amount, x, y, 0, {} });
+}
+
+void queueExplosion(World& g, float x, float y, float sz, Color col) {
+    g.events.push_back({ EV_SPAWN_EXPLOSION, 0, -1, -1, 0, x, y, sz, col });
+}
+
+void killPlayerLife(World& g, Player& p) {
+    p.lives--;
+    if (p.lives <= 0) {
+        if (g.coop && (g.player.lives > 0 || g.wingman.lives > 0)) return;   // partner flies on
+        if (g.player.score > g.highScore) g.highScore = g.player.score;
+        g.state = STATE_GAMEOVER;
+        g.gameoverTimer = 0;
+    } else {
+        p.hp = p.maxHp;
+        p.invTimer = 3.0f;
+    }
+}
+
+void resolveEvents(World& g) {
+    Player& p = g.player;
+    // Indexed: resolving appends kills and spawns to the same queue
+    for (size_t i = 0; i < g.events.size(); i++) {
+        const GameEvent ev = g.events[i];
+        const HitRule& rule = HIT_RULES[ev.source];
+        switch (ev.type) {
+        case EV_HIT: {
+            EnemyJet& e = enemyAt(g.enemies, ev.target);
+            if (!e.active) break;
+            if (ev.source == SRC_BULLET)  g.bullets.dead[ev.slot] = 1;
+            if (ev.source == SRC_MISSILE) g.missiles.items[ev.slot].active = false;
+            e.hp -= ev.amount;
+            queueExplosion(g, ev.x, ev.y, rule.hitFx, C_FIRE);
+            cueSound(SFX_HIT, ev.x);
+            if (e.hp <= 0) {
+                e.active = false;
+                queueEvent(g, EV_KILL, ev.source, ev.target, -1, 0, e.x, e.y);
+            }
+            break;
+        }
+        case EV_KILL: {
+            const Archetype& a = ARCHETYPES[refType(ev.target)];
+            p.score += a.score * (rule.killScoreMul ? rule.killScoreMul : 1 + g.combo/5);
+            p.kills++;
+            if (rule.countsCombo) {
+                g.combo++;
+                g.comboTimer = 2.0f;
+            }
+            if (a.boss) { g.bossAlive = false; p.level++; }
+            queueExplosion(g, ev.x, ev.y, a.deathFx, C_FIRE);
+            cueSound(a.boss ? SFX_BIG_EXPLOSION : SFX_EXPLOSION, ev.x);
+            if (rule.dropOdds && g.rng.below(rule.dropOdds) == 0)
+                queueEvent(g, EV_SPAWN_POWERUP, ev.source, -1, -1, 0, ev.x, ev.y);
             break;
-        case 1: // fast
-            e.hp = e.maxHp = 20;
-            e.vx = (rand()%2 ? 120.0f : -120.0f);
-            e.vy = 160.0f;
-            e.shootInterval = 1.0f;
-            e.score = 200;
+        }
+        case EV_PLAYER_DAMAGED: {
+            Player& hit = playerAt(g, ev.target);
+            if (hit.invTimer > 0 || !jetInPlay(g, hit)) break;
+            if (ev.source == SRC_BULLET)  g.bullets.dead[ev.slot] = 1;
+            if (ev.source == SRC_MISSILE) g.missiles.items[ev.slot].active = false;
+            if (rule.shieldable && hit.shieldActive && hit.shield > 0) {
+                hit.shield = std::max(0, hit.shield - ev.amount);
+            } else {
+                hit.hp -= ev.amount;
+            }
+            hit.invTimer = rule.playerInv;
+            queueExplosion(g, hit.x, hit.y, rule.playerFx, {100,100,255,255});
+            cueSound(SFX_PLAYER_HIT, hit.x);
+            if (hit.hp <= 0) killPlayerLife(g, hit);
             break;
-        case 2: // heavy
-            e.hp = e.maxHp = 80;
-            e.vx = (rand()%2 ? 40.0f : -40.0f);
-            e.vy = 60.0f;
-            e.shootInterval = 0.8f;
-            e.score = 500;
+        }
+        case EV_SPAWN_EXPLOSION:
+            spawnExplosion(g, ev.x, ev.y, ev.size, ev.col);
             break;
-        case 3: // boss
-            e.x = SCREEN_W / 2.0f;
-            e.hp = e.maxHp = 500;
-            e.vx = 100.0f;
-            e.vy = 30.0f;
-            e.shootInterval = 0.4f;
-            e.score = 5000;
+        case EV_SPAWN_POWERUP:
+            spawnPowerup(g, ev.x, ev.y);
             break;
+        }
     }
-    e.type = type;
-    e.shootTimer = e.shootInterval;
-    g.enemies.push_back(e);
+    g.events.clear();
 }
 
 // ==================== DRAW JET (Player) ====================
-void drawPlayerJet(SDL_Renderer* r, float x, float y, float tiltX, float thrusterAnim, float invTimer) {
-    // Blink if invincible
-    if (invTimer > 0 && (int)(invTimer * 10) % 2 == 0) return;
-    
-    int cx = (int)x, cy = (int)y;
-    float tx = tiltX; // -1=left, 0=straight, 1=right
-    
-    // Thruster flame
-    int flameH = (int)(20 + sinf(thrusterAnim * 10) * 8);
-    Color flameCol = { 255, (Uint8)(100 + sinf(thrusterAnim*15)*80), 0, 255 };
-    fillRect(r, cx-8,  cy+40, 16, flameH, flameCol);
-    fillRect(r, cx-14, cy+38, 8,  flameH-5, {255,200,50,255});
-    fillRect(r, cx+6,  cy+38, 8,  flameH-5, {255,200,50,255});
-    
+// Static airframe for one tilt bucket (tiltPx = (int)(tiltX*5)); baked
+// into the atlas, or drawn directly when no atlas is available
+void drawPlayerJetBody(SDL_Renderer* r, int cx, int cy, int tiltPx) {
     // Wings
     // Left wing
-    SDL_Point leftWing[4] = {{cx, cy+10}, {cx-50+(int)(tx*5), cy+20}, {cx-45+(int)(tx*5), cy+30}, {cx, cy+25}};
-    setColor(r, C_JET);
+    SDL_Point leftWing[4] = {{cx, cy+10}, {cx-50+tiltPx, cy+20}, {cx-45+tiltPx, cy+30}, {cx, cy+25}};
     for (int i = 0; i < 3; i++)
-        SDL_RenderDrawLine(r, leftWing[i].x, leftWing[i].y, leftWing[i+1].x, leftWing[i+1].y);
-    fillRect(r, cx-50+(int)(tx*5), cy+20, 50, 10, C_JET);
+        drawLine(r, leftWing[i].x, leftWing[i].y, leftWing[i+1].x, leftWing[i+1].y, C_JET);
+    fillRect(r, cx-50+tiltPx, cy+20, 50, 10, C_JET);
     
     // Right wing
-    SDL_Point rightWing[4] = {{cx, cy+10}, {cx+50+(int)(tx*5), cy+20}, {cx+45+(int)(tx*5), cy+30}, {cx, cy+25}};
+    SDL_Point rightWing[4] = {{cx, cy+10}, {cx+50+tiltPx, cy+20}, {cx+45+tiltPx, cy+30}, {cx, cy+25}};
     for (int i = 0; i < 3; i++)
-        SDL_RenderDrawLine(r, rightWing[i].x, rightWing[i].y, rightWing[i+1].x, rightWing[i+1].y);
-    fillRect(r, cx, cy+20, 50+(int)(tx*5), 10, C_JET);
+        drawLine(r, rightWing[i].x, rightWing[i].y, rightWing[i+1].x, rightWing[i+1].y, C_JET);
+    fillRect(r, cx, cy+20, 50+tiltPx, 10, C_JET);
     
     // Fuselage
     fillRect(r, cx-12, cy-40, 24, 80, C_JET);
@@ -592,21 +2258,40 @@ void drawPlayerJet(SDL_Renderer* r, float x, float y, float tiltX, float thruste
     // Gun barrels
     fillRect(r, cx-15, cy-5, 4, 20, C_JET_DARK);
     fillRect(r, cx+11, cy-5, 4, 20, C_JET_DARK);
+}
+
+void drawPlayerJet(SDL_Renderer* r, const SpriteAtlas* atlas, float x, float y, float tiltX, float thrusterAnim, float invTimer) {
+    // Blink if invincible
+    if (invTimer > 0 && (int)(invTimer * 10) % 2 == 0) return;
+    
+    int cx = (int)x, cy = (int)y;
+    int tiltPx = (int)(tiltX * PLAYER_TILT_STEPS); // -5=left, 0=straight, 5=right
+    
+    // Thruster flame
+    int flameH = (int)(20 + fsin(thrusterAnim * 10) * 8);
+    Color flameCol = { 255, (Uint8)(100 + fsin(thrusterAnim*15)*80), 0, 255 };
+    fillRect(r, cx-8,  cy+40, 16, flameH, flameCol);
+    fillRect(r, cx-14, cy+38, 8,  flameH-5, {255,200,50,255});
+    fillRect(r, cx+6,  cy+38, 8,  flameH-5, {255,200,50,255});
+    
+    if (!drawSprite(r, atlas, SPR_PLAYER + tiltPx + PLAYER_TILT_STEPS, cx, cy))
+        drawPlayerJetBody(r, cx, cy, tiltPx);
     
     // Wing tip lights (blink)
     Color tipCol = ((int)(SDL_GetTicks()/200) % 2) ? C_RED : C_WHITE;
-    fillRect(r, cx-50+(int)(tx*5), cy+22, 5, 5, tipCol);
-    fillRect(r, cx+45+(int)(tx*5), cy+22, 5, 5, {0,255,80,255});
+    fillRect(r, cx-50+tiltPx, cy+22, 5, 5, tipCol);
+    fillRect(r, cx+45+tiltPx, cy+22, 5, 5, {0,255,80,255});
 }
 
 // ==================== DRAW ENEMY JET ====================
-void drawEnemyJet(SDL_Renderer* r, EnemyJet& e) {
-    int cx = (int)e.x, cy = (int)e.y;
+const Color C_BOSS = { 150, 0, 200, 255 };
+
+// Static airframe per enemy type; baked into the atlas
+void drawEnemyJetBody(SDL_Renderer* r, int cx, int cy, int type) {
     Color mainCol = C_ENEMY;
-    float hpRatio = (float)e.hp / e.maxHp;
     
-    if (e.type == 3) { // Boss - larger and more complex
-        mainCol = { 150, 0, 200, 255 };
+    if (type == 3) { // Boss - larger and more complex
+        mainCol = C_BOSS;
         // Large wings
         fillRect(r, cx-80, cy, 80, 25, mainCol);
         fillRect(r, cx, cy, 80, 25, mainCol);
@@ -621,15 +2306,11 @@ void drawEnemyJet(SDL_Renderer* r, EnemyJet& e) {
         // Cannons
         fillRect(r, cx-30, cy+10, 6, 30, {100, 0, 150, 255});
         fillRect(r, cx+24, cy+10, 6, 30, {100, 0, 150, 255});
-        // HP bar for boss
-        fillRect(r, 50, 10, SCREEN_W-100, 20, {60,0,0,255});
-        fillRect(r, 50, 10, (int)((SCREEN_W-100)*hpRatio), 20, {200,0,50,255});
-        drawPixelText(r, "BOSS", SCREEN_W/2-24, 12, 4, C_WHITE);
     } else {
         // Normal enemy jets
         Color darkCol = { (Uint8)(mainCol.r/2), (Uint8)(mainCol.g/2), (Uint8)(mainCol.b/2), 255 };
         
-        int scale = (e.type == 2) ? 2 : 1; // heavy is bigger
+        int scale = (type == 2) ? 2 : 1; // heavy is bigger
         
         // Inverted wings (pointing down = enemy)
         fillRect(r, cx-30*scale, cy, 30*scale, 8*scale, mainCol);
@@ -645,15 +2326,31 @@ void drawEnemyJet(SDL_Renderer* r, EnemyJet& e) {
         // Cockpit
         fillRect(r, cx-5*scale, cy-20*scale, 10*scale, 14*scale, darkCol);
         fillRect(r, cx-3*scale, cy-18*scale, 6*scale, 10*scale, 
-                 e.type==1 ? Color{255,50,50,255} : Color{255,150,0,255});
-        
-        // Thrusters (at top since inverted)
-        int fH = 8 + (int)(sinf(SDL_GetTicks()*0.01f)*4);
-        fillRect(r, cx-6*scale, cy-30*scale-fH, 12*scale, fH, {255,140,0,255});
+                 type==1 ? Color{255,50,50,255} : Color{255,150,0,255});
     }
+}
+
+template <int T>
+void drawEnemyJet(SDL_Renderer* r, const SpriteAtlas* atlas, const EnemyJet& e, float x, float y) {
+    constexpr const Archetype& a = ARCHETYPES[T];
+    int cx = (int)x, cy = (int)y;
+    float hpRatio = (float)e.hp / a.hp;
     
-    // HP bar (small, above enemy)
-    if (e.type != 3) {
+    if (!drawSprite(r, atlas, SPR_ENEMY_BASIC + T, cx, cy))
+        drawEnemyJetBody(r, cx, cy, T);
+    
+    if constexpr (a.boss) {
+        // HP bar for boss
+        fillRect(r, 50, 10, SCREEN_W-100, 20, {60,0,0,255});
+        fillRect(r, 50, 10, (int)((SCREEN_W-100)*hpRatio), 20, {200,0,50,255});
+        drawPixelText(r, "BOSS", SCREEN_W/2-24, 12, 4, C_WHITE);
+    } else {
+        // Thrusters (at top since inverted)
+        int scale = a.drawScale;
+        int fH = 8 + (int)(fsin(SDL_GetTicks()*0.01f)*4);
+        fillRect(r, cx-6*scale, cy-30*scale-fH, 12*scale, fH, {255,140,0,255});
+        
+        // HP bar (small, above enemy)
         int bw = 40;
         fillRect(r, cx-bw/2, cy-35, bw, 5, {60,0,0,255});
         fillRect(r, cx-bw/2, cy-35, (int)(bw*hpRatio), 5, {0,255,80,255});
@@ -661,20 +2358,29 @@ void drawEnemyJet(SDL_Renderer* r, EnemyJet& e) {
 }
 
 // ==================== DRAW POWERUP ====================
-void drawPowerup(SDL_Renderer* r, PowerUp& p) {
-    int cx = (int)p.x;
-    int cy = (int)(p.y + sinf(p.bob * 3) * 5);
+Color powerupColor(int type) {
+    switch(type) {
+        case 0: return C_GREEN;
+        case 1: return C_CYAN;
+        case 2: return C_GOLD;
+        case 3: return C_MISSILE;
+        case 4: return C_PURPLE;
+        default: return C_WHITE;
+    }
+}
+
+// Glow, disc, rim and label; baked into the atlas per type
+void drawPowerupBody(SDL_Renderer* r, int cx, int cy, int type) {
     int sz = 22;
-    
-    Color col;
+    Color col = powerupColor(type);
     const char* label;
-    switch(p.type) {
-        case 0: col = C_GREEN;  label = "HP";  break;
-        case 1: col = C_CYAN;   label = "SH";  break;
-        case 2: col = C_GOLD;   label = "RF";  break;
-        case 3: col = C_MISSILE;label = "MS";  break;
-        case 4: col = C_PURPLE; label = "BM";  break;
-        default: col = C_WHITE; label = "??"; break;
+    switch(type) {
+        case 0: label = "HP";  break;
+        case 1: label = "SH";  break;
+        case 2: label = "RF";  break;
+        case 3: label = "MS";  break;
+        case 4: label = "BM";  break;
+        default: label = "??"; break;
     }
     
     // Glow
@@ -688,20 +2394,90 @@ void drawPowerup(SDL_Renderer* r, PowerUp& p) {
     // Label
     Color darkCol = {(Uint8)(col.r/3), (Uint8)(col.g/3), (Uint8)(col.b/3), 255};
     drawPixelText(r, label, cx-8, cy-5, 2, darkCol);
+}
+
+void drawPowerup(SDL_Renderer* r, const SpriteAtlas* atlas, const PowerUp& p, float y) {
+    int cx = (int)p.x;
+    int cy = (int)(y + fsin(p.bob * 3) * 5);
+    int sz = 22;
+    Color col = powerupColor(p.type);
+    
+    bool baked = p.type >= 0 && p.type < 5 && drawSprite(r, atlas, SPR_POWERUP + p.type, cx, cy);
+    if (!baked) drawPowerupBody(r, cx, cy, p.type);
     
     // Spinning effect
     float angle = SDL_GetTicks() * 0.002f;
     for (int i = 0; i < 6; i++) {
         float a = angle + i * (M_PI / 3);
-        int ex = cx + (int)(cosf(a) * (sz+8));
-        int ey = cy + (int)(sinf(a) * (sz+8));
+        int ex = cx + (int)(fcos(a) * (sz+8));
+        int ey = cy + (int)(fsin(a) * (sz+8));
         fillRect(r, ex-2, ey-2, 4, 4, col);
     }
 }
 
+// ==================== DRAW PARTICLES ====================
+// Every live particle becomes a quad of the atlas disc, tinted and faded,
+// and the lot goes out in one additive SDL_RenderGeometry call. Without
+// the atlas they fall back to batched scanline circles.
+std::vector<SDL_Vertex> g_particleVerts;
+std::vector<int>        g_particleIdx;
+
+void drawParticles(SDL_Renderer* r, const SpriteAtlas* atlas, const ParticleRing& pr, float alpha) {
+    if (pr.live == 0) return;
+    bool textured = atlas && atlas->tex && atlas->spr[SPR_CIRCLE].src.w != 0;
+    const SDL_Rect& src = atlas ? atlas->spr[SPR_CIRCLE].src : SDL_Rect{};
+    float u0 = (float)src.x / ATLAS_W, u1 = (float)(src.x + src.w) / ATLAS_W;
+    float v0 = (float)src.y / ATLAS_H, v1 = (float)(src.y + src.h) / ATLAS_H;
+    std::vector<SDL_Vertex>& vs = g_particleVerts;
+    std::vector<int>&        is = g_particleIdx;
+    vs.clear();
+    is.clear();
+    
+    auto disc = [&](float cx, float cy, float rad, Color c) {
+        if (!textured) { drawCircle(r, (int)cx, (int)cy, (int)rad, c); return; }
+        int base = (int)vs.size();
+        SDL_Color sc = { c.r, c.g, c.b, c.a };
+        vs.push_back({ { cx - rad, cy - rad }, sc, { u0, v0 } });
+        vs.push_back({ { cx + rad, cy - rad }, sc, { u1, v0 } });
+        vs.push_back({ { cx + rad, cy + rad }, sc, { u1, v1 } });
+        vs.push_back({ { cx - rad, cy + rad }, sc, { u0, v1 } });
+        for (int k : { 0, 1, 2, 0, 2, 3 }) is.push_back(base + k);
+    };
+    
+    // Newest first, so the quality budget cuts the most faded ones
+    const QualityTier& qt = qualityTier();
+    int discs = 0, sparks = 0;
+    if (!textured) setBlendMode(r, SDL_BLENDMODE_ADD);
+    for (int k = 1; k <= MAX_PARTICLES && discs < qt.particleBudget; k++) {
+        const Particle& pt = pr.items[(pr.head - k + MAX_PARTICLES) % MAX_PARTICLES];
+        if (pt.life <= 0) continue;
+        if (pt.kind == PK_SPARK && (!qt.sparkEvery || sparks++ % qt.sparkEvery)) continue;
+        float x = lerp(pt.prevX, pt.x, alpha), y = lerp(pt.prevY, pt.y, alpha);
+        Uint8 a = (Uint8)(pt.col.a * (pt.life / pt.maxLife));
+        disc(x, y, pt.size, { pt.col.r, pt.col.g, pt.col.b, a });
+        discs++;
+        if (pt.kind == PK_BLAST) {   // hot core
+            disc(x, y, pt.size * 0.5f, { 255, 255, 200, (Uint8)(a * 0.7f) });
+            discs++;
+        }
+    }
+    if (!textured) { setBlendMode(r, SDL_BLENDMODE_NONE); return; }
+    
+    flushPrims(r);
+    SDL_SetTextureBlendMode(atlas->tex, SDL_BLENDMODE_ADD);
+    SDL_RenderGeometry(r, atlas->tex, vs.data(), (int)vs.size(), is.data(), (int)is.size());
+    profDrawCall();
+    SDL_SetTextureBlendMode(atlas->tex, SDL_BLENDMODE_BLEND);
+}
+
 // ==================== DRAW BACKGROUND (3D-like) ====================
-void drawBackground(Game& g) {
-    SDL_Renderer* r = g.renderer;
+// Sky/ground gradient and the perspective grid never change, so they are
+// drawn by drawBackgroundStatic into g.bgTex once (see RENDER CACHES) and
+// blitted. The scrolling layers are baked the same way, one wrap-around
+// strip each (drawLayerTile), and copied at their offset per frame; only
+// the sprinkle stars are drawn as shapes.
+void drawBackgroundStatic(SDL_Renderer* r) {
+    flushPrims(r);
     
     // Sky gradient
     int skyEnd = (int)(PLAY_H * 0.65f);
@@ -724,36 +2500,6 @@ void drawBackground(Game& g) {
         SDL_RenderDrawLine(r, 0, y, SCREEN_W, y);
     }
     
-    // Stars
-    for (auto& s : g.stars) {
-        Uint8 v = (Uint8)(255 * s.brightness);
-        setColor(r, {v, v, v, 255});
-        if (s.size == 1)
-            SDL_RenderDrawPoint(r, (int)s.x, (int)s.y);
-        else
-            fillRect(r, (int)s.x - s.size/2, (int)s.y - s.size/2, s.size, s.size, {v,v,v,255});
-    }
-    
-    // Clouds
-    for (auto& c : g.clouds) {
-        SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-        Uint8 a = (Uint8)c.alpha;
-        fillRect(r, (int)c.x, (int)c.y, (int)c.w, (int)c.h, {220,220,255,a});
-        fillRect(r, (int)c.x+15, (int)c.y-12, (int)(c.w*0.6f), (int)(c.h*0.7f), {240,240,255,a});
-        SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
-    }
-    
-    // Mountains (parallax)
-    for (auto& m : g.mountains) {
-        int bx = (int)m.x;
-        int bh = (int)m.h;
-        // Draw triangle mountain
-        for (int i = 0; i < bh; i++) {
-            int w = (int)((float)(bh-i)/bh * 80);
-            fillRect(r, bx - w/2, skyEnd + i - bh, w, 1, m.col);
-        }
-    }
-    
     // 3D grid lines (ground perspective)
     setColor(r, {0, 80, 0, 255});
     int horizon = skyEnd;
@@ -772,26 +2518,148 @@ void drawBackground(Game& g) {
     }
 }
 
-// ==================== DRAW HUD ====================
-void drawHUD(Game& g) {
+// One tile of a parallax layer with its top-left at (ox, oy). Drawn with
+// blending off, so the baked alpha is exactly the shape's own. Clouds near
+// the top or bottom edge are drawn on both sides so the strip wraps.
+void drawLayerTile(SDL_Renderer* r, int id, int ox, int oy) {
+    const ParallaxLayer& l = PARALLAX[id];
+    int tw = l.tileW ? l.tileW : SCREEN_W;
+    Rng rng;
+    rng.seed(l.seed, RNG_RENDER);
+    switch (l.kind) {
+    case LK_STARS:
+        for (int i = 0; i < l.count; i++) {
+            int size = 1 + rng.below(l.sizeMax);
+            int x = rng.below(tw - size), y = rng.below(l.tileH - size);
+            Uint8 v = (Uint8)(255 * (l.brightMin + (1 - l.brightMin) * rng.uniform()));
+            fillRect(r, ox + x, oy + y, size, size, {v,v,v,255});
+        }
+        break;
+    case LK_CLOUDS:
+        for (int i = 0; i < l.count; i++) {
+            int x = rng.below(tw) - 60, y = rng.below(l.tileH);
+            int w = 80 + rng.below(120), h = 30 + rng.below(40);
+            Uint8 ca = (Uint8)(40 + rng.below(60));
+            for (int wrap = -1; wrap <= 1; wrap++) {
+                int cy = oy + y + wrap * l.tileH;
+                fillRect(r, ox + x, cy, w, h, {220,220,255,ca});
+                fillRect(r, ox + x + 15, cy - 12, (int)(w*0.6f), (int)(h*0.7f), {240,240,255,ca});
+            }
+        }
+        break;
+    case LK_MOUNTAINS:
+        for (int i = 0; i < l.count; i++) {
+            int cx = ox + i * (tw / l.count) + tw / (2 * l.count);
+            int bh = 100 + rng.below(std::min(150, l.tileH - 100));
+            Color col = { (Uint8)(20 + rng.below(30)), (Uint8)(60 + rng.below(40)), (Uint8)(20 + rng.below(20)), 255 };
+            for (int row = 0; row < bh; row++) {
+                int w = (int)((float)(row + 1) / bh * 80);
+                fillRect(r, cx - w/2, oy + l.tileH - bh + row, w, 1, col);
+            }
+        }
+        break;
+    }
+}
+
+// The layer's strip copied as often as it takes to cover the play field
+void drawParallax(Game& g, const World& w, int id, int skyEnd) {
+    const ParallaxLayer& l = PARALLAX[id];
     SDL_Renderer* r = g.renderer;
-    Player& p = g.player;
+    float wrap = layerWrap(l);
+    float d = w.layerScroll[id] - w.layerPrev[id];
+    if (d < 0) d += wrap;   // wrapped during the last step
+    int off = (int)fmodf(w.layerPrev[id] + d * w.renderAlpha, wrap);
+    int tw = l.tileW ? l.tileW : SCREEN_W;
+    auto copy = [&](int x, int y) {
+        if (g.layerTex[id]) {
+            SDL_Rect dst = {x, y, tw, l.tileH};
+            renderCopy(r, g.layerTex[id], nullptr, &dst);
+        } else {
+            if (l.kind == LK_CLOUDS) setBlendMode(r, SDL_BLENDMODE_BLEND);
+            drawLayerTile(r, id, x, y);
+            if (l.kind == LK_CLOUDS) setBlendMode(r, SDL_BLENDMODE_NONE);
+        }
+    };
+    if (l.horizontal) {
+        for (int x = -off; x < SCREEN_W; x += tw) copy(x, skyEnd - l.tileH);
+    } else {
+        for (int y = off - l.tileH; y < PLAY_H; y += l.tileH) copy(0, y);
+    }
+}
+
+void drawBackground(Game& g, const World& w) {
+    ProfileScope prof(PH_BACKGROUND);
+    SDL_Renderer* r = g.renderer;
+    float a = w.renderAlpha;
+    int skyEnd = (int)(PLAY_H * 0.65f);
     
-    int hudY = PLAY_H;
+    // Gradient + grid
+    if (g.bgTex) {
+        SDL_Rect dst = {0, 0, SCREEN_W, PLAY_H};
+        renderCopy(r, g.bgTex, nullptr, &dst);
+    } else {
+        drawBackgroundStatic(r);
+    }
+    
+    const QualityTier& qt = qualityTier();
+    
+    // Stars: baked strips, then the sprinkle
+    if (qt.starLayers > 1) drawParallax(g, w, LAYER_STARS_FAR, skyEnd);
+    if (qt.starLayers > 0) drawParallax(g, w, LAYER_STARS_NEAR, skyEnd);
+    for (const Star& s : w.stars) {
+        Uint8 v = (Uint8)(255 * s.brightness);
+        int sy = (int)lerp(s.prevY, s.y, a);
+        fillRect(r, (int)s.x - s.size/2, sy - s.size/2, s.size, s.size, {v,v,v,255});
+    }
     
+    // Clouds, then mountains (parallax)
+    if (qt.cloudLayers > 1) drawParallax(g, w, LAYER_CLOUDS_FAR, skyEnd);
+    if (qt.cloudLayers > 0) drawParallax(g, w, LAYER_CLOUDS_NEAR, skyEnd);
+    drawParallax(g, w, LAYER_MOUNTAINS, skyEnd);
+}
+
+// ==================== DRAW HUD ====================
+HudState captureHud(const World& g) {
+    const Player& p = g.player;
+    HudState h;
+    h.hp = p.hp;         h.maxHp = p.maxHp;
+    h.shield = p.shield; h.maxShield = p.maxShield;
+    h.score = p.score;   h.level = p.level;   h.lives = p.lives;
+    h.ammo = p.ammo;     h.bombs = p.bombs;
+    h.combo = g.combo > 1 ? g.combo : 0;
+    h.rapidFire = p.rapidFire ? 1 : 0;
+    const Player* wing = wingmanInPlay(g);
+    h.wingHp = wing ? std::max(0, wing->hp) : -1;
+    h.wingMaxHp = wing ? wing->maxHp : 0;
+    return h;
+}
+
+struct HudButtons { SDL_Rect fire, missile, bomb, pause; };
+
+HudButtons hudButtons(int hudY) {
+    HudButtons b;
+    b.fire    = { SCREEN_W - 130, hudY + 80, 100, 60 };
+    b.missile = { SCREEN_W - 260, hudY + 90, 80, 50 };
+    b.bomb    = { 20, hudY + 90, 80, 50 };
+    b.pause   = { SCREEN_W/2 - 30, hudY + 88, 60, 40 };
+    return b;
+}
+
+// Draws the panel with its top edge at hudY
+void drawHUDContents(SDL_Renderer* r, const HudState& h, int hudY) {
     // HUD background
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
+    setBlendMode(r, SDL_BLENDMODE_BLEND);
     fillRect(r, 0, hudY, SCREEN_W, HUD_H, {0,0,20,230});
     // Top border glow
     fillRect(r, 0, hudY, SCREEN_W, 3, C_CYAN);
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+    setBlendMode(r, SDL_BLENDMODE_NONE);
     
     // === HP Bar ===
     int barW = 180, barH = 18;
     int barX = 10, barY = hudY + 10;
     fillRect(r, barX, barY, barW, barH, {60,0,0,255});
-    int hpW = (int)(barW * (float)p.hp / p.maxHp);
-    Color hpCol = p.hp > 50 ? Color{0,220,80,255} : p.hp > 25 ? Color{255,180,0,255} : Color{255,50,50,255};
+    int hpW = (int)(barW * (float)h.hp / h.maxHp);
+    Color hpCol = h.hp > 50 ? Color{0,220,80,255} : h.hp > 25 ? Color{255,180,0,255} : Color{255,50,50,255};
     fillRect(r, barX, barY, hpW, barH, hpCol);
     drawRing(r, barX+barW/2, barY+barH/2, barH/2+1, 0, {255,255,255,40});
     drawPixelText(r, "HP", barX+2, barY+2, 3, C_WHITE);
@@ -799,22 +2667,22 @@ void drawHUD(Game& g) {
     // === Shield Bar ===
     barY += barH + 5;
     fillRect(r, barX, barY, barW, barH, {0,0,60,255});
-    int shW = (int)(barW * (float)p.shield / p.maxShield);
+    int shW = (int)(barW * (float)h.shield / h.maxShield);
     fillRect(r, barX, barY, shW, barH, C_CYAN);
     drawPixelText(r, "SH", barX+2, barY+2, 3, C_WHITE);
     
     // === Score ===
     char scoreBuf[32];
-    snprintf(scoreBuf, 32, "SCORE %d", p.score);
+    snprintf(scoreBuf, 32, "SCORE %d", h.score);
     drawPixelText(r, scoreBuf, SCREEN_W/2 - 60, hudY+8, 3, C_GOLD);
     
     // === Level ===
     char lvlBuf[16];
-    snprintf(lvlBuf, 16, "LV %d", p.level);
+    snprintf(lvlBuf, 16, "LV %d", h.level);
     drawPixelText(r, lvlBuf, SCREEN_W/2 - 30, hudY+28, 3, C_CYAN);
     
     // === Lives ===
-    for (int i = 0; i < p.lives; i++) {
+    for (int i = 0; i < h.lives; i++) {
         // Draw tiny jet icon
         int lx = SCREEN_W - 20 - i * 28;
         int ly = hudY + 10;
@@ -823,70 +2691,109 @@ void drawHUD(Game& g) {
         fillRect(r, lx+2, ly+5, 8, 5, C_JET);
     }
     
+    // === Wingman HP ===
+    if (h.wingHp >= 0) {
+        int wx = SCREEN_W - 200, wy = hudY + 32, ww = 110;
+        drawPixelText(r, "ALLY", wx - 52, wy, 3, C_GREEN);
+        fillRect(r, wx, wy, ww, 12, {60,0,0,255});
+        int wingW = (int)(ww * (float)h.wingHp / h.wingMaxHp);
+        Color wingCol = h.wingHp > 50 ? Color{0,220,80,255} : h.wingHp > 25 ? Color{255,180,0,255} : Color{255,50,50,255};
+        fillRect(r, wx, wy, wingW, 12, wingCol);
+    }
+    
     // === Ammo / Bombs ===
     char ammoBuf[32];
-    snprintf(ammoBuf, 32, "MS %d  BM %d", p.ammo, p.bombs);
+    snprintf(ammoBuf, 32, "MS %d  BM %d", h.ammo, h.bombs);
     drawPixelText(r, ammoBuf, 10, hudY + 55, 3, C_WHITE);
     
     // === Combo ===
-    if (g.combo > 1) {
-        char comboBuf[16];
-        snprintf(comboBuf, 16, "X%d COMBO", g.combo);
+    if (h.combo > 1) {
+        char comboBuf[24];
+        snprintf(comboBuf, 24, "X%d COMBO", h.combo);
         drawPixelText(r, comboBuf, SCREEN_W/2 - 60, hudY + 55, 3, C_GOLD);
     }
     
     // === Rapid Fire indicator ===
-    if (p.rapidFire) {
+    if (h.rapidFire) {
         drawPixelText(r, "RAPID!", SCREEN_W - 90, hudY + 55, 3, C_GOLD);
     }
     
     // === Action Buttons ===
+    HudButtons b = hudButtons(hudY);
     // Fire button (right side)
-    g.btnFire = { SCREEN_W - 130, hudY + 80, 100, 60 };
-    drawCircle(r, g.btnFire.x + g.btnFire.w/2, g.btnFire.y + g.btnFire.h/2, 42, {200, 50, 50, 200});
-    drawRing(r, g.btnFire.x + g.btnFire.w/2, g.btnFire.y + g.btnFire.h/2, 42, 38, C_WHITE);
-    drawPixelText(r, "FIRE", g.btnFire.x+10, g.btnFire.y+22, 4, C_WHITE);
+    drawCircle(r, b.fire.x + b.fire.w/2, b.fire.y + b.fire.h/2, 42, {200, 50, 50, 200});
+    drawRing(r, b.fire.x + b.fire.w/2, b.fire.y + b.fire.h/2, 42, 38, C_WHITE);
+    drawPixelText(r, "FIRE", b.fire.x+10, b.fire.y+22, 4, C_WHITE);
     
     // Missile button
-    g.btnMissile = { SCREEN_W - 260, hudY + 90, 80, 50 };
-    Color msCol = p.ammo > 0 ? C_MISSILE : Color{80,80,80,255};
-    drawCircle(r, g.btnMissile.x + g.btnMissile.w/2, g.btnMissile.y + g.btnMissile.h/2, 30, msCol);
-    drawRing(r, g.btnMissile.x + g.btnMissile.w/2, g.btnMissile.y + g.btnMissile.h/2, 30, 27, C_WHITE);
-    drawPixelText(r, "MS", g.btnMissile.x+12, g.btnMissile.y+15, 4, C_WHITE);
+    Color msCol = h.ammo > 0 ? C_MISSILE : Color{80,80,80,255};
+    drawCircle(r, b.missile.x + b.missile.w/2, b.missile.y + b.missile.h/2, 30, msCol);
+    drawRing(r, b.missile.x + b.missile.w/2, b.missile.y + b.missile.h/2, 30, 27, C_WHITE);
+    drawPixelText(r, "MS", b.missile.x+12, b.missile.y+15, 4, C_WHITE);
     
     // Bomb button
-    g.btnBomb = { 20, hudY + 90, 80, 50 };
-    Color bmCol = p.bombs > 0 ? C_PURPLE : Color{80,80,80,255};
-    drawCircle(r, g.btnBomb.x + g.btnBomb.w/2, g.btnBomb.y + g.btnBomb.h/2, 30, bmCol);
-    drawRing(r, g.btnBomb.x + g.btnBomb.w/2, g.btnBomb.y + g.btnBomb.h/2, 30, 27, C_WHITE);
-    drawPixelText(r, "BM", g.btnBomb.x+12, g.btnBomb.y+15, 4, C_WHITE);
+    Color bmCol = h.bombs > 0 ? C_PURPLE : Color{80,80,80,255};
+    drawCircle(r, b.bomb.x + b.bomb.w/2, b.bomb.y + b.bomb.h/2, 30, bmCol);
+    drawRing(r, b.bomb.x + b.bomb.w/2, b.bomb.y + b.bomb.h/2, 30, 27, C_WHITE);
+    drawPixelText(r, "BM", b.bomb.x+12, b.bomb.y+15, 4, C_WHITE);
     
     // Pause button
-    g.btnPause = { SCREEN_W/2 - 30, hudY + 88, 60, 40 };
-    fillRect(r, g.btnPause.x, g.btnPause.y, g.btnPause.w, g.btnPause.h, {40,40,80,200});
-    drawPixelText(r, "II", g.btnPause.x+12, g.btnPause.y+8, 4, C_WHITE);
+    fillRect(r, b.pause.x, b.pause.y, b.pause.w, b.pause.h, {40,40,80,200});
+    drawPixelText(r, "II", b.pause.x+12, b.pause.y+8, 4, C_WHITE);
+}
+
+// The panel is drawn into g.hudTex over the clear color, so it is opaque
+// and composites with one copy. Falls back to drawing directly when render
+// targets are unavailable.
+void drawHUD(Game& g, const World& w) {
+    ProfileScope prof(PH_HUD);
+    SDL_Renderer* r = g.renderer;
+    HudState h = captureHud(w);
+    
+    if (!g.hudTex) {
+        drawHUDContents(r, h, PLAY_H);
+        return;
+    }
+    if (!g.hudValid || memcmp(&h, &g.hudDrawn, sizeof h) != 0) {
+        flushPrims(r);
+        SDL_Texture* prevTarget = SDL_GetRenderTarget(r);
+        if (SDL_SetRenderTarget(r, g.hudTex) == 0) {
+            SDL_SetRenderDrawColor(r, 0, 0, 20, 255);
+            SDL_RenderClear(r);
+            drawHUDContents(r, h, 0);
+            flushPrims(r);
+            SDL_SetRenderTarget(r, prevTarget);
+            g.hudDrawn = h;
+            g.hudValid = true;
+        } else {
+            drawHUDContents(r, h, PLAY_H);
+            return;
+        }
+    }
+    SDL_Rect dst = { 0, PLAY_H, SCREEN_W, HUD_H };
+    renderCopy(r, g.hudTex, nullptr, &dst);
 }
 
 // ==================== DRAW MENU ====================
-void drawMenu(Game& g) {
+void drawMenu(Game& g, const World& w) {
     SDL_Renderer* r = g.renderer;
     float t = g.menuAnim;
     
     // Background
-    drawBackground(g);
+    drawBackground(g, w);
     
     // Animated stars glow
     for (int i = 0; i < 5; i++) {
         float a = t * 0.5f + i * 1.2f;
-        int sx = (int)(SCREEN_W * 0.5f + cosf(a) * 200);
-        int sy = (int)(PLAY_H * 0.3f + sinf(a * 1.3f) * 100);
+        int sx = (int)(SCREEN_W * 0.5f + fcos(a) * 200);
+        int sy = (int)(PLAY_H * 0.3f + fsin(a * 1.3f) * 100);
         drawCircle(r, sx, sy, 3, C_GOLD);
     }
     
     // Title Panel
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
+    setBlendMode(r, SDL_BLENDMODE_BLEND);
     fillRect(r, 30, 80, SCREEN_W-60, 200, {0,0,40,200});
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+    setBlendMode(r, SDL_BLENDMODE_NONE);
     fillRect(r, 30, 80, SCREEN_W-60, 4, C_CYAN);
     fillRect(r, 30, 276, SCREEN_W-60, 4, C_CYAN);
     
@@ -895,8 +2802,8 @@ void drawMenu(Game& g) {
     drawPixelText(r, "JET 3D", 80, 175, 10, C_CYAN);
     
     // Animated jet on menu
-    float jetY = 350.0f + sinf(t * 2) * 20;
-    drawPlayerJet(r, SCREEN_W/2.0f, jetY, sinf(t*0.5f)*0.3f, t, 0);
+    float jetY = 350.0f + fsin(t * 2) * 20;
+    drawPlayerJet(r, &g.atlas, SCREEN_W/2.0f, jetY, fsin(t*0.5f)*0.3f, t, 0);
     
     // Blink "TAP TO START"
     if ((int)(t * 2) % 2 == 0) {
@@ -904,16 +2811,16 @@ void drawMenu(Game& g) {
     }
     
     // High score
-    if (g.highScore > 0) {
+    if (w.highScore > 0) {
         char hsBuf[32];
-        snprintf(hsBuf, 32, "BEST %d", g.highScore);
+        snprintf(hsBuf, 32, "BEST %d", w.highScore);
         drawPixelText(r, hsBuf, SCREEN_W/2-60, 580, 4, C_GOLD);
     }
     
     // Controls hint
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
+    setBlendMode(r, SDL_BLENDMODE_BLEND);
     fillRect(r, 20, 640, SCREEN_W-40, 120, {0,0,30,180});
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+    setBlendMode(r, SDL_BLENDMODE_NONE);
     drawPixelText(r, "DRAG TO MOVE", 60, 655, 3, C_CYAN);
     drawPixelText(r, "FIRE - SHOOT GUNS", 60, 680, 3, C_WHITE);
     drawPixelText(r, "MS   - FIRE MISSILE", 60, 700, 3, C_MISSILE);
@@ -924,14 +2831,14 @@ void drawMenu(Game& g) {
 }
 
 // ==================== DRAW GAME OVER ====================
-void drawGameOver(Game& g) {
+void drawGameOver(Game& g, const World& w) {
     SDL_Renderer* r = g.renderer;
-    drawBackground(g);
+    drawBackground(g, w);
     
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
+    setBlendMode(r, SDL_BLENDMODE_BLEND);
     fillRect(r, 0, 0, SCREEN_W, PLAY_H, {0,0,0,150});
     fillRect(r, 40, 200, SCREEN_W-80, 600, {20,0,0,220});
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+    setBlendMode(r, SDL_BLENDMODE_NONE);
     
     fillRect(r, 40, 200, SCREEN_W-80, 4, C_RED);
     fillRect(r, 40, 796, SCREEN_W-80, 4, C_RED);
@@ -940,30 +2847,30 @@ void drawGameOver(Game& g) {
     drawPixelText(r, "OVER", 90, 340, 12, C_RED);
     
     char scoreBuf[32], killBuf[32], lvlBuf[32];
-    snprintf(scoreBuf, 32, "SCORE  %d", g.player.score);
-    snprintf(killBuf, 32, "KILLS  %d", g.player.kills);
-    snprintf(lvlBuf, 32, "LEVEL  %d", g.player.level);
+    snprintf(scoreBuf, 32, "SCORE  %d", w.player.score);
+    snprintf(killBuf, 32, "KILLS  %d", w.player.kills);
+    snprintf(lvlBuf, 32, "LEVEL  %d", w.player.level);
     
     drawPixelText(r, scoreBuf, 80, 480, 4, C_GOLD);
     drawPixelText(r, killBuf,  80, 520, 4, C_WHITE);
     drawPixelText(r, lvlBuf,   80, 560, 4, C_CYAN);
     
-    if (g.player.score >= g.highScore) {
+    if (w.player.score >= w.highScore) {
         drawPixelText(r, "NEW RECORD!", 80, 610, 5, C_GOLD);
     }
     
-    if ((int)(g.gameoverTimer * 2) % 2 == 0)
+    if ((int)(w.gameoverTimer * 2) % 2 == 0)
         drawPixelText(r, "TAP TO RESTART", 70, 680, 4, C_WHITE);
 }
 
 // ==================== DRAW PAUSE ====================
-void drawPause(Game& g) {
+void drawPause(Game& g, const World& w) {
     SDL_Renderer* r = g.renderer;
     
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
+    setBlendMode(r, SDL_BLENDMODE_BLEND);
     fillRect(r, 0, 0, SCREEN_W, SCREEN_H, {0,0,0,150});
     fillRect(r, 80, 400, SCREEN_W-160, 400, {0,20,60,230});
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+    setBlendMode(r, SDL_BLENDMODE_NONE);
     
     fillRect(r, 80, 400, SCREEN_W-160, 4, C_CYAN);
     fillRect(r, 80, 796, SCREEN_W-160, 4, C_CYAN);
@@ -972,14 +2879,209 @@ void drawPause(Game& g) {
     drawPixelText(r, "TAP TO RESUME", 80, 600, 4, C_WHITE);
     
     char scoreBuf[32];
-    snprintf(scoreBuf, 32, "SCORE %d", g.player.score);
+    snprintf(scoreBuf, 32, "SCORE %d", w.player.score);
     drawPixelText(r, scoreBuf, 100, 680, 4, C_GOLD);
 }
 
+// ==================== DRAW PROFILER OVERLAY ====================
+void drawProfilerOverlay(Game& g, const World& w) {
+    const Profiler& pf = g_prof;
+    if (!pf.show) return;
+    SDL_Renderer* r = g.renderer;
+    const int scale = 2, lineH = 7 * scale, x = 8, y = 40;
+    const int nLines = PH_COUNT + (w.netStats.line[0] ? 4 : 3);
+    
+    setBlendMode(r, SDL_BLENDMODE_BLEND);
+    fillRect(r, x - 4, y - 4, 30 * GLYPH_ADVANCE * scale, nLines * lineH + 6, {0,0,0,170});
+    setBlendMode(r, SDL_BLENDMODE_NONE);
+    
+    drawPixelText(r, "MS         P50   P95   P99", x, y, scale, C_CYAN);
+    for (int i = 0; i <= PH_COUNT; i++) {
+        if (!pf.lines[i][0]) continue;
+        Color c = (i == PH_FRAME || i == PH_COUNT) ? C_GOLD : C_WHITE;
+        drawPixelText(r, pf.lines[i], x, y + (i + 1) * lineH, scale, c);
+    }
+    drawPixelText(r, g_quality.line, x, y + (PH_COUNT + 2) * lineH, scale, C_GOLD);
+    if (w.netStats.line[0]) drawPixelText(r, w.netStats.line, x, y + (PH_COUNT + 3) * lineH, scale, C_GREEN);
+}
+
+// ==================== JOB SYSTEM ====================
+// Fans independent update phases out over a few helper threads. Every
+// thread owns a small deque: owners pop from the back, idle threads steal
+// from the front of the others, and the submitter works too until its
+// batch is done. Jobs must touch disjoint state; anything that orders
+// results (rng draws, hits, scores) stays serial in updateGame, so the
+// sim is bit-identical with any worker count.
+const int JOB_MAX_WORKERS = 3;
+const int JOB_QUEUE_CAP   = 16;   // per thread; overflow runs inline
+const int JOB_MAX_CPUS    = 16;
+
+typedef void (*JobFn)(World& w, int lo, int hi);
+struct Job { JobFn fn; int lo, hi; };
+
+struct JobQueue {
+    SDL_mutex* lock = nullptr;
+    Job        items[JOB_QUEUE_CAP];
+    int        count = 0;
+};
+
+struct JobSystem {
+    int               workers = 0;            // helper threads; slot 0 is the submitter
+    int               cores = 0, bigCores = 0;
+    Uint32            littleMask = 0;         // LITTLE cluster on big.LITTLE, else 0
+    JobQueue          queues[JOB_MAX_WORKERS + 1];
+    SDL_Thread*       threads[JOB_MAX_WORKERS] = {};
+    ProfTicks         prof[JOB_MAX_WORKERS + 1];  // helpers' timings, merged per batch
+    SDL_sem*          wake = nullptr;
+    World*            world = nullptr;        // batch in flight
+    std::atomic<int>  pending{0};
+    std::atomic<bool> quit{false};
+};
+JobSystem g_jobs;
+
+bool takeJob(JobQueue& q, Job& j, bool steal) {
+    SDL_LockMutex(q.lock);
+    bool ok = q.count > 0;
+    if (ok) {
+        if (steal) {
+            j = q.items[0];
+            memmove(q.items, q.items + 1, --q.count * sizeof(Job));
+        } else {
+            j = q.items[--q.count];
+        }
+    }
+    SDL_UnlockMutex(q.lock);
+    return ok;
+}
+
+bool runOneJob(JobSystem& js, int slot) {
+    int n = js.workers + 1;
+    Job j;
+    bool got = takeJob(js.queues[slot], j, false);
+    for (int k = 1; !got && k < n; k++) got = takeJob(js.queues[(slot + k) % n], j, true);
+    if (!got) return false;
+    j.fn(*js.world, j.lo, j.hi);
+    js.pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+int jobWorkerMain(void* data) {
+    JobSystem& js = g_jobs;
+    int slot = (int)(intptr_t)data;
+    t_prof = &js.prof[slot];
+    t_traceTid = TRACE_TID_SIM + slot;
+#ifdef __linux__
+    // The render and sim threads want the big cores; helpers live on the
+    // LITTLE cluster and anything they are slow on gets stolen back
+    if (js.littleMask) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c = 0; c < JOB_MAX_CPUS; c++)
+            if (js.littleMask & (1u << c)) CPU_SET(c, &set);
+        sched_setaffinity(0, sizeof set, &set);
+    }
+#endif
+    for (;;) {
+        SDL_SemWait(js.wake);
+        if (js.quit) break;
+        while (js.pending.load(std::memory_order_acquire) > 0 && runOneJob(js, slot)) {}
+    }
+    return 0;
+}
+
+int readCpuMaxFreq(int cpu) {
+    char path[80];
+    snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+    SDL_RWops* f = SDL_RWFromFile(path, "rb");
+    if (!f) return 0;
+    char buf[24] = {};
+    SDL_RWread(f, buf, 1, sizeof buf - 1);
+    SDL_RWclose(f);
+    return atoi(buf);
+}
+
+// Sizes the pool to the cores left after the render and sim threads.
+// Pass workers >= 0 to override (bench runs).
+void initJobs(int workers = -1) {
+    JobSystem& js = g_jobs;
+    js.cores = SDL_GetCPUCount();
+    int freq[JOB_MAX_CPUS], fmax = 0, fmin = 0;
+    int probed = std::min(js.cores, JOB_MAX_CPUS);
+    for (int c = 0; c < probed; c++) {
+        freq[c] = readCpuMaxFreq(c);
+        fmax = std::max(fmax, freq[c]);
+        if (freq[c] && (!fmin || freq[c] < fmin)) fmin = freq[c];
+    }
+    js.bigCores = js.cores;
+    if (fmax && fmin < fmax) {
+        js.bigCores = 0;
+        for (int c = 0; c < probed; c++) {
+            if (freq[c] == fmax) js.bigCores++;
+            else if (freq[c]) js.littleMask |= 1u << c;
+        }
+    }
+    js.workers = workers >= 0 ? std::min(workers, JOB_MAX_WORKERS)
+                              : std::max(0, std::min(js.cores - 2, JOB_MAX_WORKERS));
+    
+    js.wake = SDL_CreateSemaphore(0);
+    for (int i = 0; i <= js.workers; i++) js.queues[i].lock = SDL_CreateMutex();
+    for (int i = 0; i < js.workers; i++) {
+        js.threads[i] = SDL_CreateThread(jobWorkerMain, "job", (void*)(intptr_t)(i + 1));
+        if (!js.threads[i]) {
+            SDL_Log("Job thread failed: %s", SDL_GetError());
+            js.workers = i;
+            break;
+        }
+    }
+    SDL_Log("Jobs: %d cores (%d big), %d helper threads", js.cores, js.bigCores, js.workers);
+}
+
+void shutdownJobs() {
+    JobSystem& js = g_jobs;
+    js.quit = true;
+    for (int i = 0; i < js.workers; i++) SDL_SemPost(js.wake);
+    for (int i = 0; i < js.workers; i++) SDL_WaitThread(js.threads[i], nullptr);
+    for (JobQueue& q : js.queues) {
+        if (q.lock) SDL_DestroyMutex(q.lock);
+        q.lock = nullptr;
+    }
+    if (js.wake) SDL_DestroySemaphore(js.wake);
+    js.wake = nullptr;
+    js.workers = 0;
+}
+
+// Runs a batch to completion; returns once every job has finished
+void runJobs(World& w, const Job* jobs, int n) {
+    JobSystem& js = g_jobs;
+    if (js.workers == 0) {
+        for (int i = 0; i < n; i++) jobs[i].fn(w, jobs[i].lo, jobs[i].hi);
+        return;
+    }
+    js.world = &w;
+    js.pending.store(n, std::memory_order_relaxed);
+    for (int i = 0; i < n; i++) {
+        JobQueue& q = js.queues[i % (js.workers + 1)];
+        SDL_LockMutex(q.lock);
+        bool queued = q.count < JOB_QUEUE_CAP;
+        if (queued) q.items[q.count++] = jobs[i];
+        SDL_UnlockMutex(q.lock);
+        if (!queued) {
+            jobs[i].fn(w, jobs[i].lo, jobs[i].hi);
+            js.pending.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    for (int i = 0; i < std::min(js.workers, n - 1); i++) SDL_SemPost(js.wake);
+    while (js.pending.load(std::memory_order_acquire) > 0)
+        runOneJob(js, 0);   // spins on the last stragglers
+    for (int i = 1; i <= js.workers; i++) {
+        t_prof->mergeFrom(js.prof[i]);
+        js.prof[i] = {};
+    }
+}
+
 // ==================== UPDATE GAME ====================
-void playerShoot(Game& g) {
-    Player& p = g.player;
-    if (p.shootTimer > 0) return;
+void playerShoot(World& g, Player& p) {
+    if (p.shootTimer > 0 || !jetInPlay(g, p)) return;
     
     float cd = p.rapidFire ? 0.05f : p.shootCooldown;
     p.shootTimer = cd;
@@ -987,46 +3089,39 @@ void playerShoot(Game& g) {
     // Double barrel
     spawnBullet(g, p.x-15, p.y-40, 0, -700, false, C_BULLET, 10);
     spawnBullet(g, p.x+15, p.y-40, 0, -700, false, C_BULLET, 10);
+    cueSound(SFX_SHOT, p.x);
     
     // Screen flash (tiny)
     g.shakeAmt = 2;
     g.shakeTimer = 0.03f;
 }
 
-void playerFireMissile(Game& g) {
-    Player& p = g.player;
-    if (p.ammo <= 0) return;
+void playerFireMissile(World& g, Player& p) {
+    if (p.ammo <= 0 || !jetInPlay(g, p)) return;
     p.ammo--;
     
     // Find nearest enemy
-    float nearDist = 9999;
+    float nearDist = 9999.0f * 9999.0f;
     float tx = p.x, ty = -100;
-    for (auto& e : g.enemies) {
-        if (!e.active) continue;
-        float d = dist2D(p.x, p.y, e.x, e.y);
+    forEachBySpawn(g.enemies, [&](int, const EnemyJet& e) {
+        if (!e.active) return;
+        float d = dist2DSq(p.x, p.y, e.x, e.y);
         if (d < nearDist) { nearDist = d; tx = e.x; ty = e.y; }
-    }
+    });
     spawnMissile(g, p.x, p.y-40, tx, ty, false, 50);
+    cueSound(SFX_MISSILE, p.x);
 }
 
-void playerBomb(Game& g) {
-    Player& p = g.player;
-    if (p.bombs <= 0) return;
+void playerBomb(World& g, Player& p) {
+    if (p.bombs <= 0 || !jetInPlay(g, p)) return;
     p.bombs--;
+    cueSound(SFX_BOMB, SCREEN_W/2);
     
     // Destroy/damage all enemies
-    for (auto& e : g.enemies) {
-        if (!e.active) continue;
-        e.hp -= 150;
-        spawnExplosion(g, e.x, e.y, 60, C_FIRE);
-        if (e.hp <= 0) {
-            e.active = false;
-            p.score += e.score;
-            p.kills++;
-            g.combo++;
-            g.comboTimer = 2.0f;
-        }
-    }
+    forEachBySpawn(g.enemies, [&](int ref, const EnemyJet& e) {
+        queueEvent(g, EV_HIT, SRC_BOMB, ref, -1, 150, e.x, e.y);
+    });
+    resolveEvents(g);
     
     // Big screen flash
     g.shakeAmt = 20;
@@ -1034,136 +3129,228 @@ void playerBomb(Game& g) {
     spawnExplosion(g, SCREEN_W/2, PLAY_H/2, 300, C_PURPLE);
 }
 
-void updateGame(Game& g) {
+// Remembers where everything was before this step so the renderer can
+// interpolate; spawns and wrap-arounds set prev themselves (bullets do it
+// in integrateBullets)
+void savePrevPositions(World& g) {
+    g.player.prevX = g.player.x;
+    g.player.prevY = g.player.y;
+    g.wingman.prevX = g.wingman.x;
+    g.wingman.prevY = g.wingman.y;
+    for (auto& v : g.enemies.of)
+        for (auto& e : v)       { e.prevX = e.x; e.prevY = e.y; }
+    for (auto& m : g.missiles)  { m.prevX = m.x; m.prevY = m.y; }
+    for (auto& pu : g.powerups) pu.prevY = pu.y;
+    for (auto& s : g.stars)     s.prevY = s.y;
+    for (int i = 0; i < LAYER_COUNT; i++) g.layerPrev[i] = g.layerScroll[i];
+}
+
+// Update phases that run as jobs; see updateGame for what may overlap
+void jobScroll(World& g, int, int) {
+    ProfileScope prof(PH_SCROLL);
     float dt = g.dt;
-    Player& p = g.player;
-    
-    // Timers
+    for (auto& s : g.stars) {
+        s.y += s.speed * dt;
+        if (s.y > PLAY_H) { s.y = s.prevY = 0; s.x = (float)g.fxRng.below(SCREEN_W); }
+    }
+    for (int i = 0; i < LAYER_COUNT; i++)
+        g.layerScroll[i] = fmodf(g.layerScroll[i] + PARALLAX[i].speed * dt, layerWrap(PARALLAX[i]));
+}
+
+void jobBuildGrid(World& g, int, int) {
+    ProfileScope prof(PH_GRID);
+    buildGrid(g.enemyGrid, g.enemies);
+}
+
+void jobMoveBullets(World& g, int, int) {
+    ProfileScope prof(PH_BULLETS);
+    BulletStore& bs = g.bullets;
+    integrateBullets(bs, g.dt);
+    cullBullets(bs, -20, -20, SCREEN_W+20, PLAY_H+20);
+    markBulletsNear(bs, g.player.x, g.player.y, 30);
+}
+
+// Per-archetype enemy behaviour. One instantiation per type, so the
+// archetype's stats are constants and the boss branch is resolved at
+// compile time instead of per enemy.
+template <int T>
+struct EnemyKernel {
+    static constexpr const Archetype& A = ARCHETYPES[T];
+
+    static void move(EnemyJet& e, float dt) {
+        e.moveTimer += dt;
+        if constexpr (A.boss) {
+            e.x += e.vx * dt;
+            e.y += e.vy * dt * 0.2f;
+            if (e.x < 80 || e.x > SCREEN_W-80) e.vx = -e.vx;
+            if (e.y > 200) e.vy = -abs(e.vy);
+            if (e.y < 50) e.vy = abs(e.vy);
+        } else {
+            e.x += e.vx * dt;
+            e.y += e.vy * dt;
+            // Bounce off walls
+            if (e.x < 30 || e.x > SCREEN_W-30) e.vx = -e.vx;
+            // Wavey movement
+            e.x += sinf(e.moveTimer * 2) * 30 * dt;
+        }
+        // Off screen
+        if (e.y > PLAY_H + 100) { e.active = false; return; }
+        e.shootTimer -= dt;
+    }
+
+    static void fire(World& g, EnemyJet& e) {
+        const Player& p = aimTarget(g, e.x, e.y);
+        e.shootTimer = A.shootInterval;
+        float dx = p.x - e.x;
+        float dy = p.y - e.y;
+        float len = sqrtf(dx*dx+dy*dy);
+        if (len > 0) { dx /= len; dy /= len; }
+        
+        float spd = A.shotSpeed;
+        spawnBullet(g, e.x, e.y, dx*spd, dy*spd, true, {255,50,50,255}, A.shotDamage);
+        
+        if constexpr (A.boss) {
+            if (g.gameTime > 60) {
+                // Boss fires spread
+                for (int i = -2; i <= 2; i++) {
+                    float a = atan2f(dy, dx) + i * 0.3f;
+                    spawnBullet(g, e.x, e.y, cosf(a)*300, sinf(a)*300, true, {255,100,0,255}, 15);
+                }
+            }
+        }
+        if constexpr (A.missileOdds != 0) {
+            if (g.rng.below(A.missileOdds) == 0)
+                spawnMissile(g, e.x, e.y, p.x, p.y, true, 25);
+        }
+    }
+};
+
+// Movement and shot timers for enemies [lo, hi) of type T; firing stays serial
+template <int T>
+void jobMoveEnemies(World& g, int lo, int hi) {
+    ProfileScope prof(PH_ENEMIES);
+    float dt = g.dt;
+    std::vector<EnemyJet>& v = g.enemies.of[T];
+    for (int i = lo; i < hi; i++)
+        if (v[i].active) EnemyKernel<T>::move(v[i], dt);
+}
+
+typedef void (*EnemyFireFn)(World&, EnemyJet&);
+const EnemyFireFn ENEMY_FIRE[ENEMY_TYPES] = {
+    EnemyKernel<ENEMY_BASIC>::fire, EnemyKernel<ENEMY_FAST>::fire,
+    EnemyKernel<ENEMY_HEAVY>::fire, EnemyKernel<ENEMY_BOSS>::fire,
+};
+
+void jobAgeParticles(World& g, int, int) {
+    ProfileScope prof(PH_EXPLOSIONS);
+    ageParticles(g.particles, g.dt);
+}
+
+void jobMovePowerups(World& g, int, int) {
+    ProfileScope prof(PH_POWERUPS);
+    for (auto& pu : g.powerups) {
+        pu.y += pu.vy * g.dt;
+        pu.bob += g.dt;
+    }
+}
+
+void tickJetTimers(Player& p, float dt) {
     p.shootTimer   = std::max(0.0f, p.shootTimer - dt);
     p.invTimer     = std::max(0.0f, p.invTimer - dt);
     p.rapidTimer   = std::max(0.0f, p.rapidTimer - dt);
     if (p.rapidTimer <= 0) p.rapidFire = false;
     p.thrusterAnim += dt;
-    p.tiltX = clamp(p.tiltX * 0.9f, -1, 1); // decay tilt
-    
-    g.shakeTimer = std::max(0.0f, g.shakeTimer - dt);
-    g.comboTimer = std::max(0.0f, g.comboTimer - dt);
-    if (g.comboTimer <= 0) g.combo = 0;
-    
-    g.gameTime += dt;
-    
-    // Player movement (smooth follow touch)
+    p.tiltX = clamp(p.tiltX * powf(0.9f, dt * 60.0f), -1, 1); // decay tilt, 0.9 per 60Hz frame
+}
+
+// Smooth follow toward the steering point. The co-op client predicts its
+// own jet with this too, so both ends move it the same way.
+void steerJet(Player& p, int tx, int ty, float dt) {
     if (p.dragging) {
-        float dx = g.touchX - p.x;
-        float dy = g.touchY - p.y;
+        float dx = tx - p.x;
+        float dy = ty - p.y;
         p.tiltX = clamp(dx / 100.0f, -1, 1);
         p.x += dx * dt * 8.0f;
         p.y += dy * dt * 8.0f;
     }
     p.x = clamp(p.x, 40, SCREEN_W-40);
     p.y = clamp(p.y, 60, PLAY_H-80);
+}
+
+const int ENEMY_JOB_CHUNK = 32;   // enemies per movement job
+const int ENEMY_JOBS_MAX  = 8;
+
+void updateGame(World& g) {
+    float dt = g.dt;
+    Player& p = g.player;
+    Player& wing = g.wingman;
     
-    // Auto-fire when dragging
-    if (p.dragging) playerShoot(g);
+    savePrevPositions(g);
     
-    // Background scroll
-    for (auto& s : g.stars) {
-        s.y += s.speed * dt;
-        if (s.y > PLAY_H) { s.y = 0; s.x = (float)(rand() % SCREEN_W); }
-    }
-    for (auto& c : g.clouds) {
-        c.y += c.speed * dt;
-        if (c.y > PLAY_H) { c.y = -c.h; c.x = (float)(rand() % SCREEN_W); }
-    }
-    for (auto& m : g.mountains) {
-        m.x -= m.speed * dt;
-        if (m.x < -100) {
-            m.x = SCREEN_W + 50;
-            m.h = 100 + rand() % 150;
-        }
-    }
+    // Timers
+    tickJetTimers(p, dt);
+    if (g.coop) tickJetTimers(wing, dt);
     
-    // Enemy spawning
-    g.enemySpawnTimer += dt;
-    float spawnInt = std::max(0.5f, g.enemySpawnInterval - g.gameTime * 0.02f);
-    if (g.enemySpawnTimer >= spawnInt) {
-        g.enemySpawnTimer = 0;
-        int type = 0;
-        if (g.gameTime > 60) type = rand() % 3;
-        else if (g.gameTime > 30) type = rand() % 2;
-        if (!g.bossAlive) spawnEnemy(g, type);
-    }
+    g.shakeTimer = std::max(0.0f, g.shakeTimer - dt);
+    g.comboTimer = std::max(0.0f, g.comboTimer - dt);
+    if (g.comboTimer <= 0) g.combo = 0;
     
-    // Boss spawn
-    if (g.gameTime > 90 && !g.bossAlive) {
-        g.bossAlive = true;
-        spawnEnemy(g, 3);
-    }
+    g.gameTime += dt;
     
-    // Powerup spawning
-    g.powerupSpawnTimer += dt;
-    if (g.powerupSpawnTimer > 12.0f) {
-        g.powerupSpawnTimer = 0;
-        spawnPowerup(g, 60 + rand() % (SCREEN_W-120), -50);
+    // Movement, and auto-fire when dragging or holding FIRE
+    if (jetInPlay(g, p)) {
+        steerJet(p, g.touchX, g.touchY, dt);
+        if (p.dragging || fingerHeld(g, ROLE_FIRE)) playerShoot(g, p);
+    }
+    if (jetInPlay(g, wing)) {
+        steerJet(wing, g.wingTouchX, g.wingTouchY, dt);
+        if (wing.dragging || g.wingFire) playerShoot(g, wing);
     }
     
-    // Update bullets
-    for (auto& b : g.bullets) {
-        if (!b.active) continue;
-        b.x += b.vx * dt;
-        b.y += b.vy * dt;
-        if (b.y < -20 || b.y > PLAY_H+20 || b.x < -20 || b.x > SCREEN_W+20)
-            b.active = false;
+    ProfileLap lap;
+    
+    // Enemy, boss and powerup spawning
+    lap.next(PH_SPAWN);
+    runWaves(g);
+    
+    // Background scroll, the broadphase for this tick's hit tests and
+    // homing, and bullet integration touch disjoint state
+    lap.stop();
+    const Job moveJobs[] = {
+        { jobScroll, 0, 0 }, { jobBuildGrid, 0, 0 }, { jobMoveBullets, 0, 0 },
+    };
+    runJobs(g, moveJobs, 3);
+    
+    // Bullet hits, in slot order
+    lap.next(PH_BULLETS);
+    BulletStore& bs = g.bullets;
+    for (int i = 0; i < bs.top; i++) {
+        if (!bs.alive[i]) continue;
+        float bx = bs.x[i], by = bs.y[i];
         
-        if (!b.isEnemy) {
+        if (!bs.isEnemy[i]) {
             // Check enemy hits
-            for (auto& e : g.enemies) {
+            for (int rank : queryGrid(g.enemyGrid, bx, by, GRID_MAX_HITR)) {
+                int ref = g.enemyGrid.refs[rank];
+                const EnemyJet& e = enemyAt(g.enemies, ref);
                 if (!e.active) continue;
-                int hitR = (e.type == 3) ? 50 : 30;
-                if (dist2D(b.x, b.y, e.x, e.y) < hitR) {
-                    b.active = false;
-                    e.hp -= b.damage;
-                    spawnExplosion(g, b.x, b.y, 20, C_FIRE);
-                    if (e.hp <= 0) {
-                        e.active = false;
-                        p.score += e.score * (1 + g.combo/5);
-                        p.kills++;
-                        g.combo++;
-                        g.comboTimer = 2.0f;
-                        if (e.type == 3) { g.bossAlive = false; p.level++; }
-                        spawnExplosion(g, e.x, e.y, (e.type == 3) ? 120 : 50, C_FIRE);
-                        if (rand() % 3 == 0) spawnPowerup(g, e.x, e.y);
-                    }
-                }
-            }
-        } else {
-            // Check player hit
-            if (p.invTimer <= 0 && dist2D(b.x, b.y, p.x, p.y) < 30) {
-                b.active = false;
-                if (p.shieldActive && p.shield > 0) {
-                    p.shield -= b.damage;
-                    if (p.shield < 0) p.shield = 0;
-                } else {
-                    p.hp -= b.damage;
-                }
-                p.invTimer = 0.5f;
-                spawnExplosion(g, p.x, p.y, 25, {100,100,255,255});
-                if (p.hp <= 0) {
-                    p.lives--;
-                    if (p.lives <= 0) {
-                        if (p.score > g.highScore) g.highScore = p.score;
-                        g.state = STATE_GAMEOVER;
-                        g.gameoverTimer = 0;
-                    } else {
-                        p.hp = p.maxHp;
-                        p.invTimer = 3.0f;
-                    }
-                }
+                int hitR = ARCHETYPES[refType(ref)].hitR;
+                if (dist2DSq(bx, by, e.x, e.y) < hitR*hitR)
+                    queueEvent(g, EV_HIT, SRC_BULLET, ref, i, bs.damage[i], bx, by);
             }
+        } else if (bs.nearPlayer[i] && p.invTimer <= 0 && jetInPlay(g, p)) {
+            queueEvent(g, EV_PLAYER_DAMAGED, SRC_BULLET, 0, i, bs.damage[i], bx, by);
+        } else if (g.coop && wing.invTimer <= 0 && jetInPlay(g, wing) &&
+                   dist2DSq(bx, by, wing.x, wing.y) < 30*30) {
+            queueEvent(g, EV_PLAYER_DAMAGED, SRC_BULLET, 1, i, bs.damage[i], bx, by);
         }
     }
+    resolveEvents(g);
+    for (int i = 0; i < bs.top; i++)
+        if (bs.alive[i] && bs.dead[i]) bs.release(i);
     
     // Update missiles
+    lap.next(PH_MISSILES);
     for (auto& m : g.missiles) {
         if (!m.active) continue;
         m.life -= dt;
@@ -1171,17 +3358,11 @@ void updateGame(Game& g) {
         
         // Homing
         if (!m.isEnemy && !g.enemies.empty()) {
-            float nearD = 9999;
-            EnemyJet* target = nullptr;
-            for (auto& e : g.enemies) {
-                if (!e.active) continue;
-                float d = dist2D(m.x, m.y, e.x, e.y);
-                if (d < nearD) { nearD = d; target = &e; }
-            }
+            int ti = nearestInGrid(g.enemyGrid, g.enemies, m.x, m.y);
+            EnemyJet* target = (ti >= 0) ? &enemyAt(g.enemies, g.enemyGrid.refs[ti]) : nullptr;
             if (target) {
                 float dx = target->x - m.x, dy = target->y - m.y;
-                float len = sqrtf(dx*dx+dy*dy);
-                if (len > 0) { dx /= len; dy /= len; }
+                fnormalize(dx, dy);
                 m.vx = lerp(m.vx, dx*500, dt*3);
                 m.vy = lerp(m.vy, dy*500, dt*3);
             }
@@ -1191,322 +3372,2924 @@ void updateGame(Game& g) {
         m.y += m.vy * dt;
         
         // Hit detection
+        int slot = (int)(&m - g.missiles.items);
         if (!m.isEnemy) {
-            for (auto& e : g.enemies) {
+            for (int rank : queryGrid(g.enemyGrid, m.x, m.y, GRID_MAX_HITR)) {
+                int ref = g.enemyGrid.refs[rank];
+                const EnemyJet& e = enemyAt(g.enemies, ref);
                 if (!e.active) continue;
-                int hitR = (e.type == 3) ? 60 : 35;
-                if (dist2D(m.x, m.y, e.x, e.y) < hitR) {
-                    m.active = false;
-                    e.hp -= m.damage;
-                    spawnExplosion(g, m.x, m.y, 60, C_FIRE);
-                    if (e.hp <= 0) {
-                        e.active = false;
-                        p.score += e.score * 2;
-                        p.kills++;
-                        if (e.type == 3) g.bossAlive = false;
-                        if (rand() % 2 == 0) spawnPowerup(g, e.x, e.y);
-                    }
-                }
-            }
-        } else {
-            if (p.invTimer <= 0 && dist2D(m.x, m.y, p.x, p.y) < 35) {
-                m.active = false;
-                p.hp -= m.damage;
-                p.invTimer = 1.0f;
-                spawnExplosion(g, p.x, p.y, 60, {100,100,255,255});
-                if (p.hp <= 0) {
-                    p.lives--;
-                    if (p.lives <= 0) { g.state = STATE_GAMEOVER; g.gameoverTimer = 0; }
-                    else { p.hp = p.maxHp; p.invTimer = 3.0f; }
-                }
+                int hitR = ARCHETYPES[refType(ref)].missileHitR;
+                if (dist2DSq(m.x, m.y, e.x, e.y) < hitR*hitR)
+                    queueEvent(g, EV_HIT, SRC_MISSILE, ref, slot, m.damage, m.x, m.y);
             }
+        } else if (p.invTimer <= 0 && jetInPlay(g, p) && dist2DSq(m.x, m.y, p.x, p.y) < 35*35) {
+            queueEvent(g, EV_PLAYER_DAMAGED, SRC_MISSILE, 0, slot, m.damage, m.x, m.y);
+        } else if (g.coop && wing.invTimer <= 0 && jetInPlay(g, wing) &&
+                   dist2DSq(m.x, m.y, wing.x, wing.y) < 35*35) {
+            queueEvent(g, EV_PLAYER_DAMAGED, SRC_MISSILE, 1, slot, m.damage, m.x, m.y);
         }
         
         if (m.y < -50 || m.y > PLAY_H+50 || m.x < -50 || m.x > SCREEN_W+50)
             m.active = false;
     }
-    
-    // Update enemies
-    for (auto& e : g.enemies) {
-        if (!e.active) continue;
-        
-        e.moveTimer += dt;
-        
-        // Boss movement pattern
-        if (e.type == 3) {
-            e.x += e.vx * dt;
-            e.y += e.vy * dt * 0.2f;
-            if (e.x < 80 || e.x > SCREEN_W-80) e.vx = -e.vx;
-            if (e.y > 200) e.vy = -abs(e.vy);
-            if (e.y < 50) e.vy = abs(e.vy);
-        } else {
-            e.x += e.vx * dt;
-            e.y += e.vy * dt;
-            // Bounce off walls
-            if (e.x < 30 || e.x > SCREEN_W-30) e.vx = -e.vx;
-            // Wavey movement
-            e.x += sinf(e.moveTimer * 2) * 30 * dt;
-        }
-        
-        // Off screen
-        if (e.y > PLAY_H + 100) { e.active = false; continue; }
-        
-        // Enemy shooting
-        e.shootTimer -= dt;
-        if (e.shootTimer <= 0) {
-            e.shootTimer = e.shootInterval;
-            float dx = p.x - e.x;
-            float dy = p.y - e.y;
-            float len = sqrtf(dx*dx+dy*dy);
-            if (len > 0) { dx /= len; dy /= len; }
-            
-            float spd = (e.type == 3) ? 350.0f : 250.0f;
-            spawnBullet(g, e.x, e.y, dx*spd, dy*spd, true, {255,50,50,255}, e.type==3 ? 20 : 10);
-            
-            if (e.type == 3 && g.gameTime > 60) {
-                // Boss fires spread
-                for (int i = -2; i <= 2; i++) {
-                    float a = atan2f(dy, dx) + i * 0.3f;
-                    spawnBullet(g, e.x, e.y, cosf(a)*300, sinf(a)*300, true, {255,100,0,255}, 15);
-                }
-            }
-            
-            if (e.type == 2 && rand()%3==0) {
-                spawnMissile(g, e.x, e.y, p.x, p.y, true, 25);
-            }
-        }
-    }
-    
-    // Update explosions
-    for (auto& ex : g.explosions) {
-        ex.life -= dt;
-        float t = 1.0f - ex.life / ex.maxLife;
-        ex.radius = ex.maxRadius * t;
+    resolveEvents(g);
+    for (auto& m : g.missiles)
+        if (!m.active) g.missiles.release(&m);
+    
+    // Enemy movement, explosion aging and powerup drift, after the hits
+    // above; each type's enemies are split into chunks
+    lap.stop();
+    Job ageJobs[ENEMY_JOBS_MAX + ENEMY_TYPES + 2];
+    int nJobs = 0, nEnemies = (int)g.enemies.size();
+    int chunk = std::max(ENEMY_JOB_CHUNK, (nEnemies + ENEMY_JOBS_MAX - 1) / ENEMY_JOBS_MAX);
+    forEachArchetype([&](auto t) {
+        constexpr int T = decltype(t)::value;
+        int n = (int)g.enemies.of[T].size();
+        for (int lo = 0; lo < n; lo += chunk)
+            ageJobs[nJobs++] = { jobMoveEnemies<T>, lo, std::min(n, lo + chunk) };
+    });
+    ageJobs[nJobs++] = { jobAgeParticles, 0, 0 };
+    ageJobs[nJobs++] = { jobMovePowerups, 0, 0 };
+    runJobs(g, ageJobs, nJobs);
+    
+    // Enemy shooting, in spawn order (rng draws and spawns). Only the few
+    // enemies due to fire this step get sorted
+    lap.next(PH_ENEMIES);
+    g.shooters.clear();
+    for (int t = 0; t < ENEMY_TYPES; t++) {
+        const std::vector<EnemyJet>& v = g.enemies.of[t];
+        for (int i = 0; i < (int)v.size(); i++)
+            if (v[i].active && v[i].shootTimer <= 0) g.shooters.push_back(enemyRef(t, i));
     }
-    g.explosions.erase(
-        std::remove_if(g.explosions.begin(), g.explosions.end(),
-                       [](const Explosion& e){ return e.life <= 0; }),
-        g.explosions.end());
-    
-    // Cleanup
-    g.bullets.erase(std::remove_if(g.bullets.begin(), g.bullets.end(),
-                    [](const Bullet& b){ return !b.active; }), g.bullets.end());
-    g.missiles.erase(std::remove_if(g.missiles.begin(), g.missiles.end(),
-                     [](const Missile& m){ return !m.active; }), g.missiles.end());
-    g.enemies.erase(std::remove_if(g.enemies.begin(), g.enemies.end(),
-                    [](const EnemyJet& e){ return !e.active; }), g.enemies.end());
-    
-    // Update powerups
+    if (g.shooters.size() > 1)
+        std::sort(g.shooters.begin(), g.shooters.end(), [&](int a, int b) {
+            return enemyAt(g.enemies, a).seq < enemyAt(g.enemies, b).seq;
+        });
+    for (int ref : g.shooters) ENEMY_FIRE[refType(ref)](g, enemyAt(g.enemies, ref));
+    
+    // Cleanup (pooled entities are released in place)
+    for (auto& v : g.enemies.of)
+        v.erase(std::remove_if(v.begin(), v.end(),
+                [](const EnemyJet& e){ return !e.active; }), v.end());
+    
+    // Powerup pickup
+    lap.next(PH_POWERUPS);
     for (auto& pu : g.powerups) {
         if (!pu.active) continue;
-        pu.y += pu.vy * dt;
-        pu.bob += dt;
-        if (pu.y > PLAY_H + 50) { pu.active = false; continue; }
+        if (pu.y > PLAY_H + 50) { g.powerups.release(&pu); continue; }
         
-        // Player collect
-        if (dist2D(pu.x, pu.y, p.x, p.y) < 40) {
+        // Player collect (the player first if both jets are on it)
+        Player* c = nullptr;
+        if (jetInPlay(g, p) && dist2DSq(pu.x, pu.y, p.x, p.y) < 40*40) c = &p;
+        else if (jetInPlay(g, wing) && dist2DSq(pu.x, pu.y, wing.x, wing.y) < 40*40) c = &wing;
+        if (c) {
             pu.active = false;
             switch(pu.type) {
-                case 0: p.hp = std::min(p.maxHp, p.hp + 30); break;
-                case 1: p.shield = std::min(p.maxShield, p.shield + 30); p.shieldActive = true; p.shieldTimer = 5.0f; break;
-                case 2: p.rapidFire = true; p.rapidTimer = 8.0f; break;
-                case 3: p.ammo += 5; break;
-                case 4: p.bombs++; break;
+                case 0: c->hp = std::min(c->maxHp, c->hp + 30); break;
+                case 1: c->shield = std::min(c->maxShield, c->shield + 30); c->shieldActive = true; c->shieldTimer = 5.0f; break;
+                case 2: c->rapidFire = true; c->rapidTimer = 8.0f; break;
+                case 3: c->ammo += 5; break;
+                case 4: c->bombs++; break;
             }
             spawnExplosion(g, pu.x, pu.y, 30, C_GREEN);
+            cueSound(SFX_POWERUP, pu.x);
             p.score += 50;
+            g.powerups.release(&pu);
         }
     }
-    g.powerups.erase(std::remove_if(g.powerups.begin(), g.powerups.end(),
-                     [](const PowerUp& p){ return !p.active; }), g.powerups.end());
     
-    // Shield timer
+    lap.stop();
+    
+    // Shield timers
     p.shieldTimer -= dt;
     if (p.shieldTimer <= 0) p.shieldActive = false;
+    if (g.coop) {
+        wing.shieldTimer -= dt;
+        if (wing.shieldTimer <= 0) wing.shieldActive = false;
+    }
     
     // Level progression
     p.level = 1 + (int)(g.gameTime / 30);
+    
+    g.tick++;
 }
 
-// ==================== RENDER GAME ====================
-void renderGame(Game& g) {
-    SDL_Renderer* r = g.renderer;
-    
-    // Screen shake offset
-    int shakeX = 0, shakeY = 0;
-    if (g.shakeTimer > 0) {
-        float amt = g.shakeAmt * (g.shakeTimer / 0.3f);
-        shakeX = (int)((rand()%3-1) * amt);
-        shakeY = (int)((rand()%3-1) * amt);
+// ==================== WARM-UP ====================
+// Nothing heavy runs before the first frame. The menu starts from the
+// glyph atlas and the HUD target, drawing everything else directly, while
+// the CPU side of the caches (background and parallax bakes, the sprite
+// atlas, the decoded sound bank) is built on a low-priority thread. The
+// main thread installs finished jobs, GPU uploads included, within
+// WARM_UPLOAD_BUDGET_MS a frame. The trig tables are constexpr (FAST
+// MATH), so they cost nothing here. Time to first frame and to fully
+// warm are logged from main()'s entry; a cache rebuild (context loss,
+// quality change) goes through the same queue.
+// Jobs are slots: a newer request for one supersedes the pending one, and
+// the thread takes the lowest slot first, so what the menu shows comes
+// before what the first run needs.
+enum WarmSlot {
+    WARM_BACKGROUND,
+    WARM_ATLAS,
+    WARM_LAYERS,                           // + parallax layer
+    WARM_SOUNDS = WARM_LAYERS + LAYER_COUNT,
+    WARM_SLOTS
+};
+
+const double WARM_UPLOAD_BUDGET_MS = 4.0;  // per frame; at least one install always fits
+
+struct WarmJob {
+    int          slot;
+    Uint32       gen;                           // superseded unless it matches Warmup::gen
+    void       (*build)(WarmJob&);              // warm-up thread: CPU work only
+    void       (*install)(Game&, WarmJob&);     // main thread
+    float        scale;                         // bake scale (background and layers)
+    SDL_Surface* surf;                          // built; freed after install
+    Uint64       buildTicks;
+};
+
+struct Warmup {
+    SDL_Thread*  thread = nullptr;
+    SDL_mutex*   lock   = nullptr;
+    SDL_sem*     wake   = nullptr;
+    bool         quit   = false;
+    bool         threadFailed = false;
+    std::vector<WarmJob> todo, done;     // under lock
+    // Main thread only
+    Uint32       gen[WARM_SLOTS] = {};
+    int          outstanding = 0;        // queued and not yet installed or dropped
+    int          installed   = 0;        // since the queue last drained
+    Uint64       buildTicks  = 0, installTicks = 0;
+    Uint64       launch    = 0;          // main() entry
+    Uint64       busySince = 0;          // outstanding went above zero
+    bool         firstFrame = false, warmedUp = false;
+};
+Warmup g_warm;
+
+double warmMs(Uint64 ticks) {
+    return ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+// Takes the lowest pending slot and builds it on the calling thread;
+// false when nothing is pending
+bool buildNextWarmJob() {
+    Warmup& wu = g_warm;
+    SDL_LockMutex(wu.lock);
+    if (wu.todo.empty()) {
+        SDL_UnlockMutex(wu.lock);
+        return false;
     }
-    
-    // Clipping to play area
-    SDL_Rect playArea = {0, 0, SCREEN_W, PLAY_H};
-    SDL_RenderSetClipRect(r, &playArea);
-    
-    // Translate for shake
-    SDL_RenderSetScale(r, 1.0f, 1.0f);
-    
-    // Draw background
-    drawBackground(g);
-    
-    // Draw powerups
-    for (auto& pu : g.powerups)
-        if (pu.active) drawPowerup(r, pu);
-    
-    // Draw enemy bullets
-    for (auto& b : g.bullets) {
-        if (!b.active) continue;
-        if (b.isEnemy) {
-            drawCircle(r, (int)b.x, (int)b.y, 6, b.col);
-            fillRect(r, (int)b.x-2, (int)b.y-2, 4, 4, C_WHITE);
+    auto next = std::min_element(wu.todo.begin(), wu.todo.end(),
+                                 [](const WarmJob& a, const WarmJob& b) { return a.slot < b.slot; });
+    WarmJob job = *next;
+    wu.todo.erase(next);
+    SDL_UnlockMutex(wu.lock);
+    
+    Uint64 t0 = profNow();
+    {
+        ProfileScope prof(PH_WARMUP);
+        job.build(job);
+    }
+    job.buildTicks = profNow() - t0;
+    SDL_LockMutex(wu.lock);
+    wu.done.push_back(job);
+    SDL_UnlockMutex(wu.lock);
+    return true;
+}
+
+int warmThreadMain(void*) {
+    Warmup& wu = g_warm;
+    // Its own profiler totals and draw count: nothing it does is in a frame
+    ProfTicks prof;
+    int drawCalls = 0;
+    t_prof = &prof;
+    t_drawCalls = &drawCalls;
+    t_traceTid = TRACE_TID_WARM;
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    for (;;) {
+        SDL_SemWait(wu.wake);
+        if (wu.quit) break;
+        while (buildNextWarmJob()) {}
+    }
+    return 0;
+}
+
+// Main thread. The thread starts with the first job; without one
+// pumpWarmup builds a job per frame itself.
+void queueWarmJob(int slot, void (*build)(WarmJob&), void (*install)(Game&, WarmJob&), float scale = 1) {
+    Warmup& wu = g_warm;
+    if (!wu.lock) {
+        wu.lock = SDL_CreateMutex();
+        wu.wake = SDL_CreateSemaphore(0);
+    }
+    if (!wu.thread && !wu.threadFailed) {
+        wu.thread = SDL_CreateThread(warmThreadMain, "warmup", nullptr);
+        if (!wu.thread) {
+            SDL_Log("Warm-up thread failed (%s), warming on the main thread", SDL_GetError());
+            wu.threadFailed = true;
         }
     }
-    
-    // Draw player bullets
-    for (auto& b : g.bullets) {
-        if (!b.active || b.isEnemy) continue;
-        fillRect(r, (int)b.x-3, (int)b.y-12, 6, 16, b.col);
-        fillRect(r, (int)b.x-1, (int)b.y-14, 2, 4, C_WHITE);
+    if (wu.outstanding == 0) {
+        wu.busySince = profNow();
+        wu.installed = 0;
+        wu.buildTicks = wu.installTicks = 0;
     }
-    
-    // Draw missiles
-    for (auto& m : g.missiles) {
-        if (!m.active) continue;
-        // Draw missile body
-        float angle = atan2f(m.vy, m.vx);
-        int mx = (int)m.x, my = (int)m.y;
-        fillRect(r, mx-3, my-10, 6, 20, m.isEnemy ? Color{255,80,0,255} : C_MISSILE);
-        // Flame trail
-        fillRect(r, mx-2, my+10, 4, 10, C_FIRE);
-        drawCircle(r, mx, my, 8, {255,100,0,80});
+    SDL_LockMutex(wu.lock);
+    for (size_t i = 0; i < wu.todo.size(); i++) {
+        if (wu.todo[i].slot != slot) continue;
+        wu.todo.erase(wu.todo.begin() + i);
+        wu.outstanding--;
+        break;
+    }
+    wu.todo.push_back({ slot, ++wu.gen[slot], build, install, scale, nullptr, 0 });
+    SDL_UnlockMutex(wu.lock);
+    wu.outstanding++;
+    if (wu.thread) SDL_SemPost(wu.wake);
+}
+
+// Main thread, once per frame before drawing: installs finished jobs
+// until the budget is spent
+void pumpWarmup(Game& g) {
+    Warmup& wu = g_warm;
+    if (wu.outstanding == 0) return;
+    if (!wu.thread) buildNextWarmJob();
+    ProfileScope prof(PH_WARMUP);
+    Uint64 t0 = profNow();
+    Uint64 budget = (Uint64)(WARM_UPLOAD_BUDGET_MS * SDL_GetPerformanceFrequency() / 1000);
+    for (;;) {
+        SDL_LockMutex(wu.lock);
+        bool any = !wu.done.empty();
+        WarmJob job = {};
+        if (any) {
+            job = wu.done.front();
+            wu.done.erase(wu.done.begin());
+        }
+        SDL_UnlockMutex(wu.lock);
+        if (!any) break;
+        
+        Uint64 t = profNow();
+        if (job.gen == wu.gen[job.slot]) {
+            job.install(g, job);
+            wu.installed++;
+            wu.buildTicks += job.buildTicks;
+        }
+        if (job.surf) SDL_FreeSurface(job.surf);
+        wu.installTicks += profNow() - t;
+        wu.outstanding--;
+        if (profNow() - t0 >= budget) break;
+    }
+}
+
+bool warmupPending() { return g_warm.outstanding > 0; }
+
+// Main thread, after each present: the startup milestones
+void endWarmupFrame() {
+    Warmup& wu = g_warm;
+    Uint64 now = profNow();
+    if (!wu.firstFrame) {
+        wu.firstFrame = true;
+        SDL_Log("Startup: first frame at %.1f ms", warmMs(now - wu.launch));
+    }
+    if (wu.outstanding > 0 || wu.busySince == 0) return;
+    if (!wu.warmedUp) {
+        wu.warmedUp = true;
+        SDL_Log("Startup: fully warm at %.1f ms (%d jobs: %.1f ms building, %.1f ms installing)",
+                warmMs(now - wu.launch), wu.installed, warmMs(wu.buildTicks), warmMs(wu.installTicks));
+    } else {
+        SDL_Log("Warm-up: %d jobs rebuilt in %.1f ms", wu.installed, warmMs(now - wu.busySince));
+    }
+    wu.busySince = 0;
+}
+
+void shutdownWarmup() {
+    Warmup& wu = g_warm;
+    if (wu.thread) {
+        wu.quit = true;
+        SDL_SemPost(wu.wake);
+        SDL_WaitThread(wu.thread, nullptr);
+        wu.thread = nullptr;
+    }
+    for (WarmJob& j : wu.todo) if (j.surf) SDL_FreeSurface(j.surf);
+    for (WarmJob& j : wu.done) if (j.surf) SDL_FreeSurface(j.surf);
+    wu.todo.clear();
+    wu.done.clear();
+    wu.outstanding = 0;
+    if (wu.lock) SDL_DestroyMutex(wu.lock);
+    if (wu.wake) SDL_DestroySemaphore(wu.wake);
+    wu.lock = nullptr;
+    wu.wake = nullptr;
+}
+
+// ==================== RENDER CACHES ====================
+// Static layers are rasterized on the CPU through a software renderer with
+// the ordinary draw helpers, on the warm-up thread (a renderer on a
+// surface touches no GPU state), then uploaded once as textures. They are
+// rebuilt when the renderer drops its textures (Android context loss) or
+// the logical size changes; until a cache lands its layer is drawn
+// directly.
+// Forces every pixel that was drawn to full alpha, so baked shapes look
+// exactly as they did when drawn straight to the screen with blending off
+void makeInkOpaque(SDL_Surface* surf) {
+    for (int y = 0; y < surf->h; y++) {
+        Uint8* px = (Uint8*)surf->pixels + y * surf->pitch;
+        for (int x = 0; x < surf->w; x++)
+            if (px[x*4 + 3]) px[x*4 + 3] = 255; // RGBA32: alpha is byte 3
+    }
+}
+
+// Any thread
+template <typename DrawFn>
+SDL_Surface* bakeSurface(int w, int h, DrawFn draw, bool opaqueInk = false) {
+    SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!surf) {
+        SDL_Log("Bake surface %dx%d failed: %s", w, h, SDL_GetError());
+        return nullptr;
+    }
+    SDL_Renderer* sw = SDL_CreateSoftwareRenderer(surf);
+    if (!sw) {
+        SDL_Log("Bake %dx%d failed: %s", w, h, SDL_GetError());
+        SDL_FreeSurface(surf);
+        return nullptr;
+    }
+    SDL_SetRenderDrawColor(sw, 0, 0, 0, 0);
+    SDL_RenderClear(sw);
+    draw(sw);
+    flushPrims(nullptr); // submit to sw and detach before it is destroyed
+    SDL_RenderFlush(sw);
+    if (opaqueInk) makeInkOpaque(surf);
+    SDL_DestroyRenderer(sw);
+    return surf;
+}
+
+// Main thread; the surface stays the caller's
+SDL_Texture* uploadSurface(SDL_Renderer* r, SDL_Surface* surf, SDL_BlendMode blend, SDL_ScaleMode scale) {
+    if (!surf) return nullptr;
+    SDL_Texture* tex = SDL_CreateTextureFromSurface(r, surf);
+    if (!tex) {
+        SDL_Log("Upload %dx%d failed: %s", surf->w, surf->h, SDL_GetError());
+        return nullptr;
+    }
+    SDL_SetTextureBlendMode(tex, blend);
+    SDL_SetTextureScaleMode(tex, scale);
+    return tex;
+}
+
+// Shelf-packs every sprite cell; sizes are the draw functions' extents
+// around the entity centre plus a pixel of margin
+void layoutAtlas(SpriteAtlas& a) {
+    int penX = 0, penY = 0, shelfH = 0;
+    auto place = [&](int id, int w, int h, int ax, int ay) {
+        const int pad = 2;
+        if (penX + w > ATLAS_W) { penX = 0; penY += shelfH + pad; shelfH = 0; }
+        if (penY + h > ATLAS_H) {
+            SDL_Log("Atlas full, sprite %d drawn directly", id);
+            a.spr[id] = {};
+            return;
+        }
+        a.spr[id] = { { penX, penY, w, h }, ax, ay };
+        penX += w + pad;
+        shelfH = std::max(shelfH, h);
+    };
+    for (int t = -PLAYER_TILT_STEPS; t <= PLAYER_TILT_STEPS; t++)
+        place(SPR_PLAYER + t + PLAYER_TILT_STEPS, 113, 109, 56, 62);
+    place(SPR_ENEMY_BASIC,  62,  62, 31, 31);
+    place(SPR_ENEMY_FAST,   62,  62, 31, 31);
+    place(SPR_ENEMY_HEAVY, 122, 122, 61, 61);
+    place(SPR_BOSS,        162, 121, 81, 80);
+    for (int t = 0; t < 5; t++)
+        place(SPR_POWERUP + t, 57, 57, 28, 28);
+    int cd = CIRCLE_SPRITE_R*2 + 1;
+    place(SPR_CIRCLE, cd, cd, CIRCLE_SPRITE_R, CIRCLE_SPRITE_R);
+}
+
+void drawAtlasContents(SDL_Renderer* r, const SpriteAtlas& a) {
+    auto origin = [&](int id, int& cx, int& cy) {
+        const Sprite& s = a.spr[id];
+        cx = s.src.x + s.ax; cy = s.src.y + s.ay;
+        return s.src.w > 0;
+    };
+    int cx, cy;
+    for (int t = -PLAYER_TILT_STEPS; t <= PLAYER_TILT_STEPS; t++)
+        if (origin(SPR_PLAYER + t + PLAYER_TILT_STEPS, cx, cy)) drawPlayerJetBody(r, cx, cy, t);
+    for (int type = 0; type < 4; type++)
+        if (origin(SPR_ENEMY_BASIC + type, cx, cy)) drawEnemyJetBody(r, cx, cy, type);
+    for (int type = 0; type < 5; type++)
+        if (origin(SPR_POWERUP + type, cx, cy)) drawPowerupBody(r, cx, cy, type);
+    if (origin(SPR_CIRCLE, cx, cy)) drawCircle(r, cx, cy, CIRCLE_SPRITE_R, C_WHITE);
+}
+
+void destroyRenderCaches(Game& g) {
+    if (g.bgTex) { SDL_DestroyTexture(g.bgTex); g.bgTex = nullptr; }
+    for (SDL_Texture*& t : g.layerTex) if (t) { SDL_DestroyTexture(t); t = nullptr; }
+    if (g.playTex) { SDL_DestroyTexture(g.playTex); g.playTex = nullptr; }
+    if (g.pauseTex) { SDL_DestroyTexture(g.pauseTex); g.pauseTex = nullptr; }
+    g.pauseValid = false;
+    if (g.atlas.tex) { SDL_DestroyTexture(g.atlas.tex); g.atlas.tex = nullptr; }
+    if (g.hudTex) { SDL_DestroyTexture(g.hudTex); g.hudTex = nullptr; }
+    g.hudValid = false;
+    destroyTextCache();
+}
+
+// Warm-up jobs for the caches. Lower tiers bake the background smaller
+// and let the GPU stretch it.
+SDL_ScaleMode bakeScaleMode(float scale) {
+    return scale < 1 ? SDL_ScaleModeLinear : SDL_ScaleModeNearest;
+}
+
+void buildBackground(WarmJob& j) {
+    float s = j.scale;
+    j.surf = bakeSurface((int)(SCREEN_W * s), (int)(PLAY_H * s), [s](SDL_Renderer* sw) {
+        SDL_RenderSetScale(sw, s, s);
+        drawBackgroundStatic(sw);
+    });
+}
+
+void installBackground(Game& g, WarmJob& j) {
+    if (g.bgTex) SDL_DestroyTexture(g.bgTex);
+    g.bgTex = uploadSurface(g.renderer, j.surf, SDL_BLENDMODE_NONE, bakeScaleMode(j.scale));
+}
+
+void buildLayer(WarmJob& j) {
+    int id = j.slot - WARM_LAYERS;
+    const ParallaxLayer& l = PARALLAX[id];
+    int tw = l.tileW ? l.tileW : SCREEN_W;
+    float s = j.scale;
+    j.surf = bakeSurface((int)(tw * s), (int)(l.tileH * s), [s, id](SDL_Renderer* sw) {
+        SDL_RenderSetScale(sw, s, s);
+        drawLayerTile(sw, id, 0, 0);
+    });
+}
+
+void installLayer(Game& g, WarmJob& j) {
+    SDL_Texture*& tex = g.layerTex[j.slot - WARM_LAYERS];
+    if (tex) SDL_DestroyTexture(tex);
+    tex = uploadSurface(g.renderer, j.surf, SDL_BLENDMODE_BLEND, bakeScaleMode(j.scale));
+}
+
+// The layout is fixed, so the thread packs its own copy rather than
+// sharing g.atlas with the frames drawn meanwhile
+void buildAtlas(WarmJob& j) {
+    SpriteAtlas layout;
+    layoutAtlas(layout);
+    j.surf = bakeSurface(ATLAS_W, ATLAS_H, [&layout](SDL_Renderer* sw) {
+        drawAtlasContents(sw, layout);
+    }, true);
+}
+
+void installAtlas(Game& g, WarmJob& j) {
+    if (g.atlas.tex) SDL_DestroyTexture(g.atlas.tex);
+    layoutAtlas(g.atlas);
+    g.atlas.tex = uploadSurface(g.renderer, j.surf, SDL_BLENDMODE_BLEND, SDL_ScaleModeNearest);
+}
+
+// Called once per frame before drawing; cheap unless something changed
+void ensureRenderCaches(Game& g) {
+    beginTextFrame();
+    int lw = 0, lh = 0;
+    SDL_RenderGetLogicalSize(g.renderer, &lw, &lh);
+    float bgScale = qualityTier().bgScale;
+    bool lost = g.cachesDirty || lw != g.cacheLogicalW || lh != g.cacheLogicalH;
+    if (lost) {
+        destroyRenderCaches(g);
+        // The minimal set the menu needs, made now
+        initTextCache(g.renderer);
+        if (SDL_RenderTargetSupported(g.renderer)) {
+            g.hudTex = SDL_CreateTexture(g.renderer, SDL_PIXELFORMAT_RGBA32,
+                                         SDL_TEXTUREACCESS_TARGET, SCREEN_W, HUD_H);
+            if (g.hudTex) SDL_SetTextureBlendMode(g.hudTex, SDL_BLENDMODE_NONE);
+        }
+        queueWarmJob(WARM_ATLAS, buildAtlas, installAtlas);
+        g.cachesDirty   = false;
+        g.cacheLogicalW = lw;
+        g.cacheLogicalH = lh;
+    }
+    // A tier change keeps drawing the old bakes until the new ones land
+    if (lost || bgScale != g.bgScale) {
+        queueWarmJob(WARM_BACKGROUND, buildBackground, installBackground, bgScale);
+        for (int i = 0; i < LAYER_COUNT; i++)
+            queueWarmJob(WARM_LAYERS + i, buildLayer, installLayer, bgScale);
+        g.bgScale = bgScale;
+    }
+    pumpWarmup(g);
+}
+
+// The play field is drawn into this when playScale() < 1 and stretched
+// over the screen; fill-rate-bound GPUs trade sharpness for frame rate,
+// while the HUD stays at native resolution. Null means draw directly.
+SDL_Texture* ensurePlayTarget(Game& g) {
+    float s = playScale();
+    if (g.playTex && g.playTexScale == s) return g.playTex;
+    if (g.playTex) { SDL_DestroyTexture(g.playTex); g.playTex = nullptr; }
+    g.playTexScale = s;
+    if (s >= 1 || !SDL_RenderTargetSupported(g.renderer)) return nullptr;
+    int tw = (int)(SCREEN_W * s), th = (int)(PLAY_H * s);
+    g.playTex = SDL_CreateTexture(g.renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, tw, th);
+    if (!g.playTex) {
+        SDL_Log("Play target %dx%d failed: %s", tw, th, SDL_GetError());
+        return nullptr;
+    }
+    SDL_SetTextureBlendMode(g.playTex, SDL_BLENDMODE_NONE);
+    SDL_SetTextureScaleMode(g.playTex, SDL_ScaleModeLinear);
+    SDL_Log("Play field at %dx%d (%.2fx)", tw, th, s);
+    return g.playTex;
+}
+
+// ==================== RENDER GAME ====================
+void renderGame(Game& g, const World& w) {
+    SDL_Renderer* r = g.renderer;
+    float a = w.renderAlpha; // positions are drawn between the last two sim steps
+    const Player& p = w.player;
+    float playerX = lerp(p.prevX, p.x, a);
+    float playerY = lerp(p.prevY, p.y, a);
+    
+    // Screen shake offset
+    int shakeX = 0, shakeY = 0;
+    if (w.shakeTimer > 0) {
+        float amt = w.shakeAmt * (w.shakeTimer / 0.3f);
+        shakeX = (int)((g.renderRng.below(3)-1) * amt);
+        shakeY = (int)((g.renderRng.below(3)-1) * amt);
+    }
+    
+    // Play field: to the screen, or scaled into the low-res target. The
+    // shake moves the whole field: drawn direct, through the viewport (the
+    // clip below is relative to it); via the target, where it is copied
+    SDL_Texture* target = ensurePlayTarget(g);
+    SDL_Texture* prevTarget = SDL_GetRenderTarget(r);
+    if (target) {
+        flushPrims(r);
+        if (SDL_SetRenderTarget(r, target) == 0) {
+            SDL_RenderSetScale(r, playScale(), playScale());
+            SDL_SetRenderDrawColor(r, 0, 0, 20, 255);
+            SDL_RenderClear(r);
+        } else {
+            target = nullptr;
+        }
     }
     
-    // Draw enemies
-    for (auto& e : g.enemies)
-        if (e.active) drawEnemyJet(r, e);
-    
-    // Draw player jet
-    drawPlayerJet(r, g.player.x, g.player.y, g.player.tiltX, g.player.thrusterAnim, g.player.invTimer);
+    // Clipping to play area
+    SDL_Rect playArea = {0, 0, SCREEN_W, PLAY_H};
+    SDL_Rect shaken = {shakeX, shakeY, SCREEN_W, PLAY_H};
+    bool shaking = shakeX != 0 || shakeY != 0;
+    if (shaking && !target) {
+        flushPrims(r);
+        SDL_RenderSetViewport(r, &shaken);
+    }
+    setClip(r, &playArea);
+    
+    // Draw background
+    drawBackground(g, w);
+    
+    ProfileLap lap;
+    lap.next(PH_ENTITIES);
+    
+    // Draw powerups
+    for (auto& pu : w.powerups)
+        if (pu.active) drawPowerup(r, &g.atlas, pu, lerp(pu.prevY, pu.y, a));
     
-    // Shield effect
-    if (g.player.shieldActive && g.player.shield > 0) {
-        float pulse = 0.7f + 0.3f * sinf(g.gameTime * 5);
+    // Draw enemy bullets
+    const BulletStore& bs = w.bullets;
+    for (int i = 0; i < bs.top; i++) {
+        if (!bs.alive[i] || !bs.isEnemy[i]) continue;
+        int bx = (int)lerp(bs.prevX[i], bs.x[i], a);
+        int by = (int)lerp(bs.prevY[i], bs.y[i], a);
+        drawCircle(r, bx, by, 6, bs.col[i]);
+        fillRect(r, bx-2, by-2, 4, 4, C_WHITE);
+    }
+    
+    // Draw player bullets
+    for (int i = 0; i < bs.top; i++) {
+        if (!bs.alive[i] || bs.isEnemy[i]) continue;
+        int bx = (int)lerp(bs.prevX[i], bs.x[i], a);
+        int by = (int)lerp(bs.prevY[i], bs.y[i], a);
+        fillRect(r, bx-3, by-12, 6, 16, bs.col[i]);
+        fillRect(r, bx-1, by-14, 2, 4, C_WHITE);
+    }
+    
+    // Draw missiles
+    for (auto& m : w.missiles) {
+        if (!m.active) continue;
+        // Draw missile body
+        int mx = (int)lerp(m.prevX, m.x, a);
+        int my = (int)lerp(m.prevY, m.y, a);
+        fillRect(r, mx-3, my-10, 6, 20, m.isEnemy ? Color{255,80,0,255} : C_MISSILE);
+        // Flame trail
+        fillRect(r, mx-2, my+10, 4, 10, C_FIRE);
+        drawCircle(r, mx, my, 8, {255,100,0,80});
+    }
+    
+    // Draw enemies
+    forEachArchetype([&](auto t) {
+        constexpr int T = decltype(t)::value;
+        for (const EnemyJet& e : w.enemies.of[T])
+            if (e.active) drawEnemyJet<T>(r, &g.atlas, e, lerp(e.prevX, e.x, a), lerp(e.prevY, e.y, a));
+    });
+    
+    // Draw the jets: the wingman under a green marker ring, then our own
+    auto drawShield = [&](const Player& j, float x, float y) {
+        if (!j.shieldActive || j.shield <= 0) return;
+        float pulse = 0.7f + 0.3f * fsin(w.gameTime * 5);
         Uint8 alpha = (Uint8)(150 * pulse);
-        SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-        drawRing(r, (int)g.player.x, (int)g.player.y, 55, 48, {0, 200, 255, alpha});
-        SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
-    }
-    
-    // Draw explosions
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-    for (auto& ex : g.explosions) {
-        float alpha = ex.life / ex.maxLife;
-        Uint8 a = (Uint8)(255 * alpha);
-        Color c = {ex.col.r, ex.col.g, ex.col.b, a};
-        drawCircle(r, (int)ex.x, (int)ex.y, (int)ex.radius, c);
-        // Inner bright
-        Color inner = {255, 255, 200, (Uint8)(a*0.7f)};
-        drawCircle(r, (int)ex.x, (int)ex.y, (int)(ex.radius*0.5f), inner);
-        // Sparks
-        for (int i = 0; i < 8; i++) {
-            float sa = i * M_PI / 4 + g.gameTime * 2;
-            float sr = ex.radius * 1.2f;
-            int sx = (int)(ex.x + cosf(sa)*sr);
-            int sy = (int)(ex.y + sinf(sa)*sr);
-            fillRect(r, sx-2, sy-2, 4, 4, {255,200,50,a});
-        }
-    }
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+        setBlendMode(r, SDL_BLENDMODE_BLEND);
+        drawRing(r, (int)x, (int)y, 55, 48, {0, 200, 255, alpha});
+        setBlendMode(r, SDL_BLENDMODE_NONE);
+    };
+    if (const Player* wing = wingmanInPlay(w)) {
+        float wx = lerp(wing->prevX, wing->x, a);
+        float wy = lerp(wing->prevY, wing->y, a);
+        setBlendMode(r, SDL_BLENDMODE_BLEND);
+        drawRing(r, (int)wx, (int)wy, 64, 60, {0, 255, 80, 110});
+        setBlendMode(r, SDL_BLENDMODE_NONE);
+        drawPlayerJet(r, &g.atlas, wx, wy, wing->tiltX, wing->thrusterAnim, wing->invTimer);
+        drawShield(*wing, wx, wy);
+    }
+    if (jetInPlay(w, p)) {
+        drawPlayerJet(r, &g.atlas, playerX, playerY, p.tiltX, p.thrusterAnim, p.invTimer);
+        drawShield(p, playerX, playerY);
+    }
+    
+    // Explosions
+    drawParticles(r, &g.atlas, w.particles, w.renderAlpha);
     
     // Combo display
-    if (g.combo > 1) {
+    if (w.combo > 1) {
         char comboBuf[16];
-        snprintf(comboBuf, 16, "X%d!", g.combo);
-        int cx = (int)g.player.x - 30;
-        int cy = (int)g.player.y - 100;
+        snprintf(comboBuf, 16, "X%d!", w.combo);
+        int cx = (int)playerX - 30;
+        int cy = (int)playerY - 100;
         drawPixelText(r, comboBuf, cx, cy, 6, C_GOLD);
     }
-    
-    SDL_RenderSetClipRect(r, nullptr);
-    
-    // Draw HUD (outside clip)
-    drawHUD(g);
+    
+    setClip(r, nullptr);
+    if (target) {
+        flushPrims(r);
+        SDL_SetRenderTarget(r, prevTarget);   // restores the logical scale
+        if (shaking) setClip(r, &playArea);
+        renderCopy(r, target, nullptr, &shaken);
+        if (shaking) setClip(r, nullptr);
+    } else if (shaking) {
+        SDL_RenderSetViewport(r, nullptr);
+    }
+    lap.stop();
+    
+    // Draw HUD (outside clip)
+    drawHUD(g, w);
+}
+
+// Nothing moves under the pause overlay, so the game is drawn once into
+// pauseTex and that is shown until play resumes or the caches are lost
+void drawPausedGame(Game& g, const World& w) {
+    SDL_Renderer* r = g.renderer;
+    if (!g.pauseValid) {
+        if (!g.pauseTex && SDL_RenderTargetSupported(r)) {
+            g.pauseTex = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, SCREEN_W, SCREEN_H);
+            if (g.pauseTex) SDL_SetTextureBlendMode(g.pauseTex, SDL_BLENDMODE_NONE);
+        }
+        flushPrims(r);
+        if (!g.pauseTex || SDL_SetRenderTarget(r, g.pauseTex) != 0) {
+            renderGame(g, w);
+            return;
+        }
+        SDL_SetRenderDrawColor(r, 0, 0, 20, 255);
+        SDL_RenderClear(r);
+        renderGame(g, w);
+        flushPrims(r);
+        SDL_SetRenderTarget(r, nullptr);
+        g.pauseValid = true;
+    }
+    renderCopy(r, g.pauseTex, nullptr, nullptr);
+}
+
+// ==================== FIXED TIMESTEP ====================
+// The sim always advances in SIM_DT steps, independent of the display
+// rate: a 120Hz panel renders about one step per frame, a 60Hz one two,
+// a 30fps device four. Leftover time carries to the next frame and the
+// renderer interpolates between the last two steps by renderAlpha.
+const int   SIM_HZ        = 120;
+const float SIM_DT        = 1.0f / SIM_HZ;
+const int   MAX_SIM_STEPS = 8;      // per frame; beyond this the sim slows down
+const float MAX_FRAME_DT  = 0.25f;  // ignore longer gaps (suspend, debugger)
+
+// ==================== HANDLE INPUT ====================
+// SDL events become InputEvents queued on Game and applied to the world
+// at a tick boundary (pumpInput), so a recorded stream replays into the
+// same ticks it was captured on.
+bool pointInRect(int x, int y, const SDL_Rect& rect) {
+    return x >= rect.x && x <= rect.x+rect.w && y >= rect.y && y <= rect.y+rect.h;
+}
+
+// A finger going down: menus and restart, the HUD buttons, or steering.
+// Returns the role the finger keeps until it lifts.
+Uint8 applyTouch(World& g, int tx, int ty) {
+    if (g.state == STATE_MENU) {
+        g.state = STATE_PLAYING;
+        return ROLE_NONE;
+    }
+    if (g.state == STATE_GAMEOVER) {
+        // Restart
+        g.player.score = 0;
+        g.enemies.clear();
+        g.bullets.clear();
+        g.missiles.clear();
+        clearParticles(g.particles);
+        g.powerups.clear();
+        g.gameTime = 0;
+        g.bossAlive = false;
+        resetWaves(g);
+        initPlayer(g.player);
+        if (g.coop) initWingman(g.wingman);
+        g.state = STATE_PLAYING;
+        return ROLE_NONE;
+    }
+    if (g.state == STATE_PAUSED) {
+        g.state = STATE_PLAYING;
+        return ROLE_NONE;
+    }
+    if (g.state != STATE_PLAYING) return ROLE_NONE;
+    
+    // Button checks
+    HudButtons b = hudButtons(PLAY_H);
+    if (pointInRect(tx, ty, b.fire)) {
+        playerShoot(g, g.player);
+        return ROLE_FIRE;
+    }
+    if (pointInRect(tx, ty, b.missile)) {
+        playerFireMissile(g, g.player);
+        return ROLE_NONE;
+    }
+    if (pointInRect(tx, ty, b.bomb)) {
+        playerBomb(g, g.player);
+        return ROLE_NONE;
+    }
+    if (pointInRect(tx, ty, b.pause)) {
+        g.state = STATE_PAUSED;
+        return ROLE_NONE;
+    }
+    
+    // Move player
+    if (ty < PLAY_H) {
+        g.touchX = tx;
+        g.touchY = ty;
+        g.player.dragging = true;
+        return ROLE_STEER;
+    }
+    return ROLE_NONE;
+}
+
+void applyInput(World& g, const InputEvent& in) {
+    switch (in.type) {
+        case IN_TOUCH:   applyTouch(g, in.x, in.y); break;
+        case IN_RELEASE: g.player.dragging = false; break;
+        case IN_FINGER_DOWN:
+            g.fingerRole[in.finger] = applyTouch(g, in.x, in.y);
+            break;
+        case IN_FINGER_MOVE:
+            // No hit tests: a steering finger may slide over the HUD
+            if (g.fingerRole[in.finger] == ROLE_STEER) {
+                g.touchX = in.x;
+                g.touchY = std::min((int)in.y, PLAY_H);
+            }
+            break;
+        case IN_FINGER_UP:
+            g.fingerRole[in.finger] = ROLE_NONE;
+            if (!fingerHeld(g, ROLE_STEER)) g.player.dragging = false;
+            break;
+        case IN_SHOOT:   if (g.state == STATE_PLAYING) playerShoot(g, g.player); break;
+        case IN_MISSILE: if (g.state == STATE_PLAYING) playerFireMissile(g, g.player); break;
+        case IN_BOMB:    if (g.state == STATE_PLAYING) playerBomb(g, g.player); break;
+        case IN_PAUSE:
+            if (g.state == STATE_PLAYING) g.state = STATE_PAUSED;
+            else if (g.state == STATE_PAUSED) g.state = STATE_PLAYING;
+            break;
+    }
+}
+
+void queueInput(Game& g, Uint8 type, int x = 0, int y = 0, int finger = 0) {
+    g.inputQueue.push({ 0, type, (Sint16)x, (Sint16)y, (Uint8)finger });
+}
+
+// The mouse is one more finger; touch-synthesized mouse events are ignored
+const SDL_FingerID MOUSE_FINGER = -1;
+const float TOUCH_PREDICT_MAX_PX = 80;   // furthest a prediction may lead
+
+int fingerSlot(TouchTracker& tt, SDL_FingerID id, bool alloc) {
+    int freeSlot = -1;
+    for (int i = 0; i < MAX_TOUCH_FINGERS; i++) {
+        if (tt.fingers[i].down && tt.fingers[i].id == id) return i;
+        if (!tt.fingers[i].down && freeSlot < 0) freeSlot = i;
+    }
+    return alloc ? freeSlot : -1;
+}
+
+// Where the finger will be predictMs after its last sample, so the jet's
+// easing starts from where the finger is going; the lead shrinks as the
+// sample ages, so a finger that stops is reached exactly
+void predictFinger(const TouchTracker& tt, const FingerTrack& f, Uint32 now, int& x, int& y) {
+    float lead = (float)std::max(0, tt.predictMs - (int)(now - f.t));
+    float dx = f.vx * lead, dy = f.vy * lead;
+    float len = sqrtf(dx*dx + dy*dy);
+    if (len > TOUCH_PREDICT_MAX_PX) { dx *= TOUCH_PREDICT_MAX_PX / len; dy *= TOUCH_PREDICT_MAX_PX / len; }
+    x = (int)(f.x + dx);
+    y = (int)(f.y + dy);
+}
+
+void sendFinger(Game& g, int slot, int x, int y) {
+    FingerTrack& f = g.touch.fingers[slot];
+    f.moved = false;
+    if (x == f.sentX && y == f.sentY) return;
+    f.sentX = x;
+    f.sentY = y;
+    queueInput(g, IN_FINGER_MOVE, x, y, slot);
+}
+
+void touchDown(Game& g, SDL_FingerID id, int x, int y, Uint32 t) {
+    int slot = fingerSlot(g.touch, id, true);
+    if (slot < 0) return;
+    FingerTrack& f = g.touch.fingers[slot];
+    f = FingerTrack();
+    f.down = true;
+    f.id = id;
+    f.x = (float)x; f.y = (float)y;
+    f.t = t;
+    f.sentX = x; f.sentY = y;
+    queueInput(g, IN_FINGER_DOWN, x, y, slot);
+}
+
+void touchMove(Game& g, SDL_FingerID id, int x, int y, Uint32 t) {
+    int slot = fingerSlot(g.touch, id, false);
+    if (slot < 0) return;
+    FingerTrack& f = g.touch.fingers[slot];
+    Uint32 dt = t - f.t;
+    if (dt > 0) {
+        // A gap this long means the finger rested; don't carry old speed over
+        float keep = dt > 100 ? 0.0f : 0.5f;
+        f.vx = f.vx * keep + (x - f.x) / dt * (1 - keep);
+        f.vy = f.vy * keep + (y - f.y) / dt * (1 - keep);
+    }
+    if (f.moved) g.touch.coalesced++;
+    f.x = (float)x; f.y = (float)y;
+    f.t = t;
+    f.moved = true;
+}
+
+void touchUp(Game& g, SDL_FingerID id) {
+    int slot = fingerSlot(g.touch, id, false);
+    if (slot < 0) return;
+    FingerTrack& f = g.touch.fingers[slot];
+    if (f.moved) sendFinger(g, slot, (int)f.x, (int)f.y);   // lift where it really is
+    f.down = false;
+    queueInput(g, IN_FINGER_UP, 0, 0, slot);
+}
+
+// Once per frame after the event loop: the newest (predicted) point of
+// every finger that moved or is still being led
+void flushTouches(Game& g) {
+    Uint32 now = SDL_GetTicks();
+    for (int i = 0; i < MAX_TOUCH_FINGERS; i++) {
+        FingerTrack& f = g.touch.fingers[i];
+        if (!f.down) continue;
+        int x = (int)f.x, y = (int)f.y;
+        if (g.touch.predictMs > 0) predictFinger(g.touch, f, now, x, y);
+        if (f.moved || x != f.sentX || y != f.sentY) sendFinger(g, i, x, y);
+    }
+}
+
+void handleTouch(Game& g, SDL_Event& ev) {
+    switch (ev.type) {
+        case SDL_FINGERDOWN:
+        case SDL_FINGERMOTION: {
+            int tx = (int)(ev.tfinger.x * SCREEN_W);
+            int ty = (int)(ev.tfinger.y * SCREEN_H);
+            if (ev.type == SDL_FINGERDOWN) touchDown(g, ev.tfinger.fingerId, tx, ty, ev.tfinger.timestamp);
+            else                           touchMove(g, ev.tfinger.fingerId, tx, ty, ev.tfinger.timestamp);
+            break;
+        }
+        case SDL_FINGERUP:
+            touchUp(g, ev.tfinger.fingerId);
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+            if (ev.button.which != SDL_TOUCH_MOUSEID)
+                touchDown(g, MOUSE_FINGER, ev.button.x, ev.button.y, ev.button.timestamp);
+            break;
+        case SDL_MOUSEMOTION:
+            if (ev.motion.which != SDL_TOUCH_MOUSEID && (ev.motion.state & SDL_BUTTON_LMASK))
+                touchMove(g, MOUSE_FINGER, ev.motion.x, ev.motion.y, ev.motion.timestamp);
+            break;
+        case SDL_MOUSEBUTTONUP:
+            if (ev.button.which != SDL_TOUCH_MOUSEID) touchUp(g, MOUSE_FINGER);
+            break;
+    }
+}
+
+// ==================== INPUT RECORDING ====================
+// File layout (little endian):
+//   header: "AFRP", u16 version, u16 SIM_HZ, u64 seed, u16 SCREEN_H (v2)
+//   events: u8 type, varint tick delta, then u8 finger for IN_FINGER_*
+//           (v3), then s16 x, s16 y for IN_TOUCH, IN_FINGER_DOWN and _MOVE
+// A recording ends with IN_END on the last tick. Replays reseed the
+// world and the layout from the header and take over the queue, so they
+// run the same on the renderer build, the headless bench and any display.
+// v1 files predate layouts and were all 1600 high; v1-2 files predate
+// multi-touch and use the single-finger IN_TOUCH / IN_RELEASE.
+// replays/ holds a v1 and a v3 recording; CI replays both on the bench
+// and checks the hashes in replays/hashes.txt, which change with gameplay.
+const Uint32 REPLAY_MAGIC   = 0x50524641; // "AFRP"
+const Uint16 REPLAY_VERSION = 3;
+
+inline bool fingerEvent(Uint8 type)  { return type >= IN_FINGER_DOWN && type <= IN_FINGER_UP; }
+inline bool pointerEvent(Uint8 type) { return type == IN_TOUCH || type == IN_FINGER_DOWN || type == IN_FINGER_MOVE; }
+
+void writeVarint(SDL_RWops* rw, Uint32 v) {
+    while (v >= 0x80) { SDL_WriteU8(rw, (Uint8)(v | 0x80)); v >>= 7; }
+    SDL_WriteU8(rw, (Uint8)v);
+}
+
+bool readVarint(SDL_RWops* rw, Uint32& v) {
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        Uint8 b;
+        if (SDL_RWread(rw, &b, 1, 1) != 1) return false;
+        v |= (Uint32)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool readLoggedEvent(InputLog& log) {
+    Uint8 type;
+    Uint32 delta;
+    if (SDL_RWread(log.rw, &type, 1, 1) != 1 || type >= IN_COUNT || !readVarint(log.rw, delta))
+        return false;
+    log.lastTick += delta;
+    log.next = { log.lastTick, type, 0, 0, 0 };
+    if (fingerEvent(type)) {
+        log.next.finger = SDL_ReadU8(log.rw);
+        if (log.next.finger >= MAX_TOUCH_FINGERS) return false;
+    }
+    if (pointerEvent(type)) {
+        log.next.x = (Sint16)SDL_ReadLE16(log.rw);
+        log.next.y = (Sint16)SDL_ReadLE16(log.rw);
+    }
+    return true;
+}
+
+bool openRecording(InputLog& log, const char* path, Uint64 seed) {
+    log = {};
+    log.rw = SDL_RWFromFile(path, "wb");
+    if (!log.rw) { SDL_Log("Cannot record to %s: %s", path, SDL_GetError()); return false; }
+    SDL_WriteLE32(log.rw, REPLAY_MAGIC);
+    SDL_WriteLE16(log.rw, REPLAY_VERSION);
+    SDL_WriteLE16(log.rw, SIM_HZ);
+    SDL_WriteLE64(log.rw, seed);
+    SDL_WriteLE16(log.rw, (Uint16)SCREEN_H);
+    SDL_Log("Recording input to %s", path);
+    return true;
+}
+
+bool openReplay(InputLog& log, const char* path, Uint64& seed) {
+    log = {};
+    log.rw = SDL_RWFromFile(path, "rb");
+    if (!log.rw) { SDL_Log("Cannot replay %s: %s", path, SDL_GetError()); return false; }
+    Uint32 magic   = SDL_ReadLE32(log.rw);
+    Uint16 version = SDL_ReadLE16(log.rw);
+    Uint16 hz      = SDL_ReadLE16(log.rw);
+    seed           = SDL_ReadLE64(log.rw);
+    if (magic != REPLAY_MAGIC || version < 1 || version > REPLAY_VERSION || hz != SIM_HZ) {
+        SDL_Log("%s: not a v1-%d replay at %d Hz", path, REPLAY_VERSION, SIM_HZ);
+        SDL_RWclose(log.rw);
+        log.rw = nullptr;
+        return false;
+    }
+    setLayout(version >= 2 ? SDL_ReadLE16(log.rw) : 1600);
+    log.replaying = true;
+    log.ended = !readLoggedEvent(log);
+    SDL_Log("Replaying %s (seed %llu, %dx%d)", path, (unsigned long long)seed, SCREEN_W, SCREEN_H);
+    return true;
+}
+
+void logInput(InputLog& log, const InputEvent& in) {
+    if (!log.rw || log.replaying) return;
+    SDL_WriteU8(log.rw, in.type);
+    writeVarint(log.rw, in.tick - log.lastTick);
+    log.lastTick = in.tick;
+    if (fingerEvent(in.type)) SDL_WriteU8(log.rw, in.finger);
+    if (pointerEvent(in.type)) {
+        SDL_WriteLE16(log.rw, (Uint16)in.x);
+        SDL_WriteLE16(log.rw, (Uint16)in.y);
+    }
+}
+
+void closeInputLog(InputLog& log, Uint32 endTick) {
+    if (!log.rw) return;
+    if (!log.replaying) logInput(log, { endTick, IN_END, 0, 0, 0 });
+    SDL_RWclose(log.rw);
+    log.rw = nullptr;
+}
+
+// Applies the input due on the world's current tick: the replay's events
+// when replaying (live input is dropped), otherwise everything queued,
+// which is stamped with the tick and recorded
+void pumpInput(World& w, InputLog& log, std::vector<InputEvent>& pending) {
+    if (log.replaying) {
+        pending.clear();
+        while (!log.ended && log.next.tick == w.tick) {
+            if (log.next.type == IN_END) { log.ended = true; break; }
+            applyInput(w, log.next);
+            log.ended = !readLoggedEvent(log);
+        }
+        return;
+    }
+    for (InputEvent& in : pending) {
+        in.tick = w.tick;
+        logInput(log, in);
+        applyInput(w, in);
+    }
+    pending.clear();
+}
+
+// ==================== SUSPEND SNAPSHOT ====================
+// Android kills backgrounded apps without further notice, so on
+// SDL_APP_WILLENTERBACKGROUND the running world is written to
+// suspend.afs in the pref path and the next launch opens on it, paused,
+// instead of on the menu. Fixed-size state goes in as raw blocks and the
+// vectors as a count plus elements, so a save is one buffer of memcpys
+// (~100 KB, a couple of ms) and one write. The header carries a version
+// and a signature of the block sizes and layout: a snapshot from another
+// build or display is dropped rather than misread. Per-tick scratch
+// (events, grid, shooter list) and held fingers are not saved.
+// Layout (native endian, same device):
+//   "AFSN", u16 version, u16 SCREEN_H, u32 layout signature, u32 body size
+const Uint32 SNAPSHOT_MAGIC   = 0x4E534641; // "AFSN"
+const Uint16 SNAPSHOT_VERSION = 1;
+const int    SNAPSHOT_HEADER  = 16;
+
+Uint32 snapshotSignature() {
+    const Uint32 sizes[] = {
+        sizeof(Player), sizeof(BulletStore), sizeof(World::missiles), sizeof(ParticleRing),
+        sizeof(World::powerups), sizeof(EnemyJet), sizeof(Star), sizeof(WaveSchedule),
+        sizeof(Rng), (Uint32)LAYER_COUNT, (Uint32)ENEMY_TYPES,
+    };
+    Uint32 h = 2166136261u;   // FNV-1a
+    for (Uint32 v : sizes) { h ^= v; h *= 16777619u; }
+    return h;
+}
+
+struct SnapshotWriter {
+    std::vector<Uint8>& out;
+    template <typename T> void operator()(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "raw block");
+        const Uint8* b = (const Uint8*)&v;
+        out.insert(out.end(), b, b + sizeof v);
+    }
+    template <typename T> void vec(const std::vector<T>& v, Uint32) {
+        (*this)((Uint32)v.size());
+        const Uint8* b = (const Uint8*)v.data();
+        out.insert(out.end(), b, b + v.size() * sizeof(T));
+    }
+};
+
+struct SnapshotReader {
+    const Uint8* p;
+    const Uint8* end;
+    bool ok = true;
+    template <typename T> void operator()(T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "raw block");
+        if (!ok || (size_t)(end - p) < sizeof v) { ok = false; return; }
+        memcpy(&v, p, sizeof v);
+        p += sizeof v;
+    }
+    template <typename T> void vec(std::vector<T>& v, Uint32 max) {
+        Uint32 n = 0;
+        (*this)(n);
+        if (!ok || n > max || (size_t)(end - p) < n * sizeof(T)) { ok = false; return; }
+        v.resize(n);
+        memcpy(v.data(), p, n * sizeof(T));
+        p += n * sizeof(T);
+    }
+};
+
+// The body, walked the same way by the writer and the reader (W is
+// const World or World), so adding a field is one line
+template <typename IO, typename W>
+void snapshotBody(IO& io, W& w) {
+    io(w.state); io(w.player);
+    io(w.bullets); io(w.missiles); io(w.particles); io(w.powerups);
+    for (auto& v : w.enemies.of) io.vec(v, 1u << ENEMY_REF_SHIFT);
+    io(w.enemies.nextSeq);
+    io.vec(w.stars, 1024);
+    io(w.layerScroll); io(w.layerPrev);
+    io(w.rng); io(w.fxRng);
+    io(w.tick); io(w.gameTime);
+    io(w.waves); io(w.cloudTimer); io(w.mountainTimer); io(w.bossSpawnTimer); io(w.bossAlive);
+    io(w.scrollY); io(w.bgScrollY); io(w.gameoverTimer);
+    io(w.combo); io(w.comboTimer); io(w.highScore);
+    io(w.shakeTimer); io(w.shakeAmt);
+    io(w.touchX); io(w.touchY);
+}
+
+void writeSnapshot(const World& w, std::vector<Uint8>& out) {
+    out.clear();
+    SnapshotWriter sw{ out };
+    sw(SNAPSHOT_MAGIC);
+    sw(SNAPSHOT_VERSION);
+    sw((Uint16)SCREEN_H);
+    sw(snapshotSignature());
+    sw((Uint32)0);   // body size, patched below
+    snapshotBody(sw, w);
+    Uint32 body = (Uint32)(out.size() - SNAPSHOT_HEADER);
+    memcpy(&out[SNAPSHOT_HEADER - 4], &body, 4);
+}
+
+// Restores into an initialised world; on false it is partly overwritten
+bool readSnapshot(World& w, const Uint8* data, size_t size) {
+    SnapshotReader sr{ data, data + size };
+    Uint32 magic = 0, sig = 0, body = 0;
+    Uint16 version = 0, screenH = 0;
+    sr(magic); sr(version); sr(screenH); sr(sig); sr(body);
+    if (!sr.ok || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION ||
+        screenH != SCREEN_H || sig != snapshotSignature() || body != size - SNAPSHOT_HEADER)
+        return false;
+    snapshotBody(sr, w);
+    if (!sr.ok || sr.p != sr.end) return false;
+    w.events.clear();
+    w.dt = SIM_DT;
+    w.simAccum = w.renderAlpha = 0;
+    w.player.dragging = false;
+    memset(w.fingerRole, 0, sizeof w.fingerRole);
+    if (w.state == STATE_PLAYING) w.state = STATE_PAUSED;
+    return true;
+}
+
+// A run in progress (playing or paused) is saved; otherwise any old
+// snapshot is removed so the next launch starts on the menu. Written to a
+// temporary and renamed, so a kill mid-write leaves the previous file.
+bool saveSuspend(const World& w, const std::string& path) {
+    if (w.state != STATE_PLAYING && w.state != STATE_PAUSED) {
+        remove(path.c_str());
+        return false;
+    }
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    std::vector<Uint8> buf;
+    writeSnapshot(w, buf);
+    std::string tmp = path + ".tmp";
+    SDL_RWops* f = SDL_RWFromFile(tmp.c_str(), "wb");
+    if (!f) { SDL_Log("Suspend: can't write %s: %s", tmp.c_str(), SDL_GetError()); return false; }
+    bool ok = SDL_RWwrite(f, buf.data(), 1, buf.size()) == buf.size();
+    ok = SDL_RWclose(f) == 0 && ok && rename(tmp.c_str(), path.c_str()) == 0;
+    SDL_Log("Suspend: %s %d bytes at tick %u in %.2f ms", ok ? "saved" : "failed to save",
+            (int)buf.size(), w.tick,
+            (SDL_GetPerformanceCounter() - t0) * 1000.0 / SDL_GetPerformanceFrequency());
+    return ok;
+}
+
+// Consumes the snapshot: if the restored run crashes the next launch
+// starts clean instead of looping on it
+bool loadSuspend(World& w, const std::string& path) {
+    SDL_RWops* f = SDL_RWFromFile(path.c_str(), "rb");
+    if (!f) return false;
+    Sint64 size = SDL_RWsize(f);
+    std::vector<Uint8> buf(size > 0 ? (size_t)size : 0);
+    bool ok = size > 0 && SDL_RWread(f, buf.data(), 1, buf.size()) == buf.size();
+    SDL_RWclose(f);
+    remove(path.c_str());
+    if (ok) {
+        std::unique_ptr<World> restored(new World(w));
+        ok = readSnapshot(*restored, buf.data(), buf.size());
+        if (ok) w = *restored;
+    }
+    SDL_Log("Suspend: %s %s", ok ? "resumed from" : "ignored stale", path.c_str());
+    return ok;
+}
+
+// The best score, kept apart from the snapshot so it survives runs that
+// end and launches with nothing to resume: "AFHS", s32 score (LE)
+const Uint32 HIGHSCORE_MAGIC = 0x53484641; // "AFHS"
+
+int loadHighScore(const std::string& path) {
+    SDL_RWops* f = SDL_RWFromFile(path.c_str(), "rb");
+    if (!f) return 0;
+    Uint32 magic = SDL_ReadLE32(f);
+    int score = (int)SDL_ReadLE32(f);
+    SDL_RWclose(f);
+    return magic == HIGHSCORE_MAGIC ? std::max(0, score) : 0;
+}
+
+void saveHighScore(const std::string& path, int score) {
+    SDL_RWops* f = SDL_RWFromFile(path.c_str(), "wb");
+    if (!f) return;
+    SDL_WriteLE32(f, HIGHSCORE_MAGIC);
+    SDL_WriteLE32(f, (Uint32)score);
+    SDL_RWclose(f);
+}
+
+// ==================== NET SNAPSHOTS ====================
+// Co-op sync (see NET SESSION). The host runs the only sim and sends a
+// snapshot every NET_SEND_TICKS; the client draws what it is sent. Moving
+// things go as quantized records: position in quarter pixels at tick t0
+// plus a velocity in px/s, which both ends extrapolate with the same
+// integer maths. A snapshot is a delta against the last view the client
+// acknowledged, and a record the client can already predict to within
+// NET_SLACK is left out, so a bullet costs one record when it is fired
+// and three bytes when it goes, however long it flies. Snapshots are
+// capped at NET_PACKET_MAX: removes go first, then records in key order
+// (enemies, missiles, powerups, enemy bullets, player bullets), and what
+// doesn't fit rides in a later one. The host keeps the view the client
+// will reconstruct, deferrals included, as the baseline for later deltas.
+// Packet (little endian):
+//   u8 'S', u8 protocol, u32 seq, u32 base seq (0: none), u32 tick,
+//   globals, u16 removes, u16 sets,
+//   removes: u8 kind, u16 id
+//   sets:    u8 kind, u16 id, u8 sub, s16 x, s16 y, s16 vx, s16 vy, s16 hp (enemies)
+const Uint8 NET_PROTOCOL   = 1;
+const Uint8 PKT_SNAPSHOT   = 'S';
+const Uint8 PKT_INPUT      = 'I';
+const int   NET_SEND_TICKS = 2;      // 60 snapshots/s
+const int   NET_PACKET_MAX = 1200;   // bytes, under a typical path MTU
+const int   NET_HISTORY    = 32;     // views kept as baselines; power of two
+const int   NET_POS_SCALE  = 4;      // quarter pixels
+const int   NET_SLACK      = 4;      // drift (quantized) tolerated before a record is resent
+
+enum NetKind : Uint8 { NK_ENEMY, NK_MISSILE, NK_POWERUP, NK_ENEMY_BULLET, NK_PLAYER_BULLET, NK_COUNT };
+
+const int   NET_BULLET_COLOR_COUNT = 3;   // the colours bullets are fired in
+const Color NET_BULLET_COLORS[NET_BULLET_COLOR_COUNT] = { C_BULLET, C_RED, C_MISSILE };
+
+struct NetEntity {
+    Uint32 key;      // kind << 16 | id (enemy seq or pool slot); views are sorted by it
+    Uint8  sub;      // enemy type, bullet colour, missile side, powerup type
+    Sint16 x, y;     // quarter pixels at t0
+    Sint16 vx, vy;   // px/s
+    Sint16 hp;       // enemies only
+    Uint32 t0;
+};
+
+inline int netKind(Uint32 key) { return (int)(key >> 16); }
+
+enum { NJ_SHIELD = 1, NJ_RAPID = 2, NJ_DRAGGING = 4 };
+
+struct NetJet {
+    Sint16 x, y;           // quarter pixels
+    Sint16 hp, shield;
+    Uint8  lives, ammo, bombs;
+    Uint8  inv;            // invTimer in 1/60 s
+    Sint8  tilt;           // tiltX * 100
+    Uint8  flags;          // NJ_*
+};
+
+struct NetGlobals {
+    Uint8  state, coop;
+    Sint32 score, highScore;
+    Uint8  level;
+    Uint16 combo;
+    Uint32 gameTimeMs;
+    Uint32 ackInput;       // newest client input the host has applied
+    NetJet jet[2];         // the host's, the client's
+};
+
+struct NetView {
+    Uint32 seq  = 0;       // 0: empty
+    Uint32 tick = 0;
+    NetGlobals glob = {};
+    std::vector<NetEntity> ents;
+};
+
+inline Sint16 netQ(float px) { return (Sint16)clamp(lroundf(px * NET_POS_SCALE), -32767, 32767); }
+inline Sint16 netV(float v)  { return (Sint16)clamp(lroundf(v), -32767, 32767); }
+
+// Where a record puts its entity `ticks` after t0, quantized
+inline int netExtrapolate(int q, int v, Uint32 ticks) {
+    return q + v * (int)ticks * NET_POS_SCALE / SIM_HZ;
+}
+
+inline bool netPredicts(const NetEntity& held, const NetEntity& now, Uint32 tick) {
+    return held.sub == now.sub && held.hp == now.hp &&
+           abs(netExtrapolate(held.x, held.vx, tick - held.t0) - now.x) <= NET_SLACK &&
+           abs(netExtrapolate(held.y, held.vy, tick - held.t0) - now.y) <= NET_SLACK;
+}
+
+// Integer fields, little endian. Both walk the same field lists.
+struct NetWriter {
+    Uint8* p;
+    template <typename T> void operator()(const T& v) {
+        static_assert(std::is_integral<T>::value, "integer field");
+        typename std::make_unsigned<T>::type u = v;
+        for (size_t i = 0; i < sizeof v; i++) *p++ = (Uint8)(u >> (i * 8));
+    }
+};
+
+struct NetReader {
+    const Uint8* p;
+    const Uint8* end;
+    bool ok = true;
+    template <typename T> void operator()(T& v) {
+        static_assert(std::is_integral<T>::value, "integer field");
+        if (!ok || end - p < (ptrdiff_t)sizeof v) { ok = false; return; }
+        typename std::make_unsigned<T>::type u = 0;
+        for (size_t i = 0; i < sizeof v; i++) u |= (decltype(u))((decltype(u))p[i] << (i * 8));
+        v = (T)u;
+        p += sizeof v;
+    }
+};
+
+template <typename IO, typename G>
+void netGlobalsIO(IO& io, G& g) {
+    io(g.state); io(g.coop); io(g.score); io(g.highScore); io(g.level); io(g.combo);
+    io(g.gameTimeMs); io(g.ackInput);
+    for (auto& j : g.jet) {
+        io(j.x); io(j.y); io(j.hp); io(j.shield);
+        io(j.lives); io(j.ammo); io(j.bombs); io(j.inv); io(j.tilt); io(j.flags);
+    }
+}
+
+template <typename IO, typename E>
+void netRecordIO(IO& io, Uint8& kind, Uint16& id, E& e) {
+    io(kind); io(id); io(e.sub); io(e.x); io(e.y); io(e.vx); io(e.vy);
+    if (kind == NK_ENEMY) io(e.hp);
+}
+
+const int NET_HEADER_BYTES = 14;
+const int NET_GLOBAL_BYTES = 21 + 2 * 14;
+const int NET_REMOVE_BYTES = 3;
+inline int netSetBytes(int kind) { return kind == NK_ENEMY ? 14 : 12; }
+
+NetJet netJet(const Player& p) {
+    NetJet j;
+    j.x = netQ(p.x);
+    j.y = netQ(p.y);
+    j.hp = (Sint16)p.hp;
+    j.shield = (Sint16)p.shield;
+    j.lives = (Uint8)clamp((float)p.lives, 0, 255);
+    j.ammo  = (Uint8)std::min(p.ammo, 255);
+    j.bombs = (Uint8)std::min(p.bombs, 255);
+    j.inv   = (Uint8)std::min(255.0f, p.invTimer * 60);
+    j.tilt  = (Sint8)lroundf(clamp(p.tiltX, -1, 1) * 100);
+    j.flags = (p.shieldActive ? NJ_SHIELD : 0) | (p.rapidFire ? NJ_RAPID : 0) | (p.dragging ? NJ_DRAGGING : 0);
+    return j;
+}
+
+void applyNetJet(const NetJet& j, Player& p) {
+    p.x = (float)j.x / NET_POS_SCALE;
+    p.y = (float)j.y / NET_POS_SCALE;
+    p.hp = j.hp;
+    p.shield = j.shield;
+    p.lives = j.lives;
+    p.ammo = j.ammo;
+    p.bombs = j.bombs;
+    p.invTimer = j.inv / 60.0f;
+    p.tiltX = j.tilt / 100.0f;
+    p.shieldActive = (j.flags & NJ_SHIELD) != 0;
+    p.rapidFire    = (j.flags & NJ_RAPID) != 0;
+    p.dragging     = (j.flags & NJ_DRAGGING) != 0;
+}
+
+// The host's world as of its current tick, for the client whose inputs
+// up to ackInput have been applied
+void captureNetView(const World& w, Uint32 ackInput, NetView& v) {
+    NetGlobals& g = v.glob;
+    v.tick = w.tick;
+    g.state = (Uint8)w.state;
+    g.coop = w.coop;
+    g.score = w.player.score;
+    g.highScore = w.highScore;
+    g.level = (Uint8)std::min(w.player.level, 255);
+    g.combo = (Uint16)std::min(w.combo, 65535);
+    g.gameTimeMs = (Uint32)(w.gameTime * 1000);
+    g.ackInput = ackInput;
+    g.jet[0] = netJet(w.player);
+    g.jet[1] = netJet(w.wingman);
+    
+    v.ents.clear();
+    auto add = [&](int kind, int id, int sub, float x, float y, float vx, float vy, int hp) {
+        v.ents.push_back({ (Uint32)(kind << 16 | (id & 0xFFFF)), (Uint8)sub,
+                           netQ(x), netQ(y), netV(vx), netV(vy), (Sint16)hp, w.tick });
+    };
+    for (int t = 0; t < ENEMY_TYPES; t++)
+        for (const EnemyJet& e : w.enemies.of[t])
+            if (e.active) add(NK_ENEMY, (int)e.seq, t, e.x, e.y, (e.x - e.prevX) * SIM_HZ, (e.y - e.prevY) * SIM_HZ, e.hp);
+    for (int i = 0; i < w.missiles.top; i++) {
+        const Missile& m = w.missiles.items[i];
+        if (w.missiles.used[i] && m.active) add(NK_MISSILE, i, m.isEnemy, m.x, m.y, m.vx, m.vy, 0);
+    }
+    for (int i = 0; i < w.powerups.top; i++) {
+        const PowerUp& pu = w.powerups.items[i];
+        if (w.powerups.used[i] && pu.active) add(NK_POWERUP, i, pu.type, pu.x, pu.y, 0, pu.vy, 0);
+    }
+    const BulletStore& bs = w.bullets;
+    for (int i = 0; i < bs.top; i++) {
+        if (!bs.alive[i]) continue;
+        int col = 0;
+        for (int c = 0; c < NET_BULLET_COLOR_COUNT; c++)
+            if (!memcmp(&bs.col[i], &NET_BULLET_COLORS[c], sizeof(Color))) col = c;
+        add(bs.isEnemy[i] ? NK_ENEMY_BULLET : NK_PLAYER_BULLET, i, col, bs.x[i], bs.y[i], bs.vx[i], bs.vy[i], 0);
+    }
+    std::sort(v.ents.begin(), v.ents.end(), [](const NetEntity& a, const NetEntity& b) { return a.key < b.key; });
+}
+
+// Host side of the stream
+struct NetSender {
+    NetView sent[NET_HISTORY];   // what the client holds after snapshot seq, at seq & (NET_HISTORY-1)
+    NetView cur;                 // this tick's world (captureNetView)
+    std::vector<Uint8> baseFate, curFate;   // scratch
+    Uint32  seq   = 0;           // last sent
+    Uint32  acked = 0;           // newest the client confirmed
+    
+    void reserve(size_t n) {
+        for (NetView& v : sent) v.ents.reserve(n);
+        cur.ents.reserve(n);
+        baseFate.reserve(n);
+        curFate.reserve(n);
+    }
+};
+
+// Client side: decoded views, by seq like NetSender::sent
+struct NetReceiver {
+    NetView views[NET_HISTORY];
+    Uint32  newest = 0;
+    std::vector<NetEntity> removed;   // dropped by the last snapshot decoded, as they were held
+    std::vector<NetEntity> sets;      // scratch
+    std::vector<Uint32>    removes;   // scratch
+    
+    void reserve(size_t n) {
+        for (NetView& v : views) v.ents.reserve(n);
+        removed.reserve(n);
+        sets.reserve(n);
+        removes.reserve(n);
+    }
+};
+
+const NetView NET_EMPTY_VIEW;
+
+// Encodes s.cur against the newest acked view into out (NET_PACKET_MAX
+// bytes) and returns the size. `deferred` counts records left for later.
+int encodeSnapshot(NetSender& s, Uint8* out, int& deferred) {
+    enum : Uint8 { KEEP, DROP, SET };
+    const Uint32 seq = s.seq + 1;
+    const Uint32 mask = NET_HISTORY - 1;
+    bool haveBase = s.acked && seq - s.acked < NET_HISTORY && s.sent[s.acked & mask].seq == s.acked;
+    const NetView& base = haveBase ? s.sent[s.acked & mask] : NET_EMPTY_VIEW;
+    const NetView& cur = s.cur;
+    size_t nb = base.ents.size(), nc = cur.ents.size();
+    
+    // What changed, by key. Base-only records go (DROP), new ones and ones
+    // the held record no longer predicts are sent (SET)
+    s.baseFate.assign(nb, KEEP);
+    s.curFate.assign(nc, KEEP);
+    for (size_t i = 0, j = 0; i < nb || j < nc;) {
+        if (j == nc || (i < nb && base.ents[i].key < cur.ents[j].key)) s.baseFate[i++] = DROP;
+        else if (i == nb || cur.ents[j].key < base.ents[i].key)      s.curFate[j++] = SET;
+        else {
+            if (!netPredicts(base.ents[i], cur.ents[j], cur.tick)) s.curFate[j] = SET;
+            i++; j++;
+        }
+    }
+    
+    // Budget: removes first, then records in key order while they fit
+    int room = NET_PACKET_MAX - NET_HEADER_BYTES - NET_GLOBAL_BYTES - 4;
+    int nRemove = 0, nSet = 0;
+    deferred = 0;
+    for (Uint8& f : s.baseFate) {
+        if (f != DROP) continue;
+        if (room >= NET_REMOVE_BYTES) { room -= NET_REMOVE_BYTES; nRemove++; }
+        else { f = KEEP; deferred++; }
+    }
+    for (size_t j = 0; j < nc; j++) {
+        if (s.curFate[j] != SET) continue;
+        int bytes = netSetBytes(netKind(cur.ents[j].key));
+        if (room >= bytes) { room -= bytes; nSet++; }
+        else { s.curFate[j] = KEEP; deferred++; }
+    }
+    
+    NetWriter nw{ out };
+    nw(PKT_SNAPSHOT); nw(NET_PROTOCOL);
+    nw(seq); nw(haveBase ? s.acked : 0u); nw(cur.tick);
+    netGlobalsIO(nw, cur.glob);
+    nw((Uint16)nRemove); nw((Uint16)nSet);
+    for (size_t i = 0; i < nb; i++) {
+        if (s.baseFate[i] != DROP) continue;
+        nw((Uint8)netKind(base.ents[i].key)); nw((Uint16)base.ents[i].key);
+    }
+    for (size_t j = 0; j < nc; j++) {
+        if (s.curFate[j] != SET) continue;
+        Uint8 kind = (Uint8)netKind(cur.ents[j].key);
+        Uint16 id = (Uint16)cur.ents[j].key;
+        netRecordIO(nw, kind, id, cur.ents[j]);
+    }
+    
+    // What the client will hold: the baseline with this snapshot applied
+    NetView& held = s.sent[seq & mask];
+    held.seq = seq;
+    held.tick = cur.tick;
+    held.glob = cur.glob;
+    held.ents.clear();
+    for (size_t i = 0, j = 0; i < nb || j < nc;) {
+        if (j == nc || (i < nb && base.ents[i].key < cur.ents[j].key)) {
+            if (s.baseFate[i] == KEEP) held.ents.push_back(base.ents[i]);
+            i++;
+        } else if (i == nb || cur.ents[j].key < base.ents[i].key) {
+            if (s.curFate[j] == SET) held.ents.push_back(cur.ents[j]);
+            j++;
+        } else {
+            held.ents.push_back(s.curFate[j] == SET ? cur.ents[j] : base.ents[i]);
+            i++; j++;
+        }
+    }
+    s.seq = seq;
+    return (int)(nw.p - out);
+}
+
+// Applies a snapshot on top of the view it was encoded against. False
+// when it is malformed, not newer than the last one, or its baseline is
+// no longer held (the host falls back to a full one once acks stall).
+bool decodeSnapshot(NetReceiver& r, const Uint8* data, int size) {
+    const Uint32 mask = NET_HISTORY - 1;
+    NetReader nr{ data, data + size };
+    Uint8 type = 0, proto = 0;
+    Uint32 seq = 0, baseSeq = 0, tick = 0;
+    nr(type); nr(proto); nr(seq); nr(baseSeq); nr(tick);
+    if (!nr.ok || type != PKT_SNAPSHOT || proto != NET_PROTOCOL || seq <= r.newest) return false;
+    if (baseSeq && (baseSeq >= seq || seq - baseSeq >= NET_HISTORY || r.views[baseSeq & mask].seq != baseSeq))
+        return false;
+    const NetView& base = baseSeq ? r.views[baseSeq & mask] : NET_EMPTY_VIEW;
+    
+    NetGlobals glob;
+    netGlobalsIO(nr, glob);
+    Uint16 nRemove = 0, nSet = 0;
+    nr(nRemove); nr(nSet);
+    r.removes.clear();
+    r.sets.clear();
+    for (int i = 0; i < nRemove && nr.ok; i++) {
+        Uint8 kind = 0; Uint16 id = 0;
+        nr(kind); nr(id);
+        r.removes.push_back((Uint32)kind << 16 | id);
+    }
+    for (int i = 0; i < nSet && nr.ok; i++) {
+        NetEntity e = {};
+        Uint8 kind = 0; Uint16 id = 0;
+        netRecordIO(nr, kind, id, e);
+        e.key = (Uint32)kind << 16 | id;
+        e.t0 = tick;
+        r.sets.push_back(e);
+    }
+    if (!nr.ok || nr.p != nr.end) return false;
+    
+    NetView& v = r.views[seq & mask];
+    v.seq = seq;
+    v.tick = tick;
+    v.glob = glob;
+    v.ents.clear();
+    r.removed.clear();
+    size_t rm = 0, st = 0;
+    for (const NetEntity& e : base.ents) {
+        while (st < r.sets.size() && r.sets[st].key < e.key) v.ents.push_back(r.sets[st++]);
+        while (rm < r.removes.size() && r.removes[rm] < e.key) rm++;
+        if (rm < r.removes.size() && r.removes[rm] == e.key) r.removed.push_back(e);
+        else if (st < r.sets.size() && r.sets[st].key == e.key) v.ents.push_back(r.sets[st++]);
+        else v.ents.push_back(e);
+    }
+    while (st < r.sets.size()) v.ents.push_back(r.sets[st++]);
+    r.newest = seq;
+    return true;
+}
+
+// Rebuilds a world's entities and jets from a view, `ahead` ticks past
+// it. `self` is the jet the world's own player is (1 on the client).
+void netViewToWorld(const NetView& v, float ahead, int self, World& w) {
+    const NetGlobals& g = v.glob;
+    w.state = (GameState)g.state;
+    w.coop = true;
+    w.gameTime = g.gameTimeMs / 1000.0f + ahead * SIM_DT;
+    w.combo = g.combo;
+    w.highScore = g.highScore;
+    applyNetJet(g.jet[self], w.player);
+    applyNetJet(g.jet[1 - self], w.wingman);
+    w.player.score = g.score;
+    w.player.level = g.level;
+    
+    auto at = [&](const NetEntity& e, float& x, float& y) {
+        float t = (float)(v.tick - e.t0) + ahead;
+        x = (e.x + e.vx * t * NET_POS_SCALE / SIM_HZ) / NET_POS_SCALE;
+        y = (e.y + e.vy * t * NET_POS_SCALE / SIM_HZ) / NET_POS_SCALE;
+    };
+    w.enemies.clear();
+    w.bullets.clear();
+    w.missiles.clear();
+    w.powerups.clear();
+    for (const NetEntity& e : v.ents) {
+        float x, y;
+        at(e, x, y);
+        switch (netKind(e.key)) {
+            case NK_ENEMY: {
+                if (e.sub >= ENEMY_TYPES) break;
+                EnemyJet j = {};
+                j.x = j.prevX = x;
+                j.y = j.prevY = y;
+                j.vx = e.vx; j.vy = e.vy;
+                j.active = true;
+                j.hp = e.hp;
+                j.seq = e.key & 0xFFFF;
+                w.enemies.of[e.sub].push_back(j);
+                break;
+            }
+            case NK_MISSILE:
+                if (Missile* m = w.missiles.acquire()) {
+                    *m = {};
+                    m->x = m->prevX = x;
+                    m->y = m->prevY = y;
+                    m->vx = e.vx; m->vy = e.vy;
+                    m->active = true;
+                    m->isEnemy = e.sub != 0;
+                }
+                break;
+            case NK_POWERUP:
+                if (PowerUp* pu = w.powerups.acquire()) {
+                    *pu = {};
+                    pu->x = x;
+                    pu->y = pu->prevY = y;
+                    pu->vy = e.vy;
+                    pu->active = true;
+                    pu->type = e.sub;
+                    pu->bob = w.gameTime;
+                }
+                break;
+            case NK_ENEMY_BULLET:
+            case NK_PLAYER_BULLET: {
+                int i = w.bullets.acquire();
+                if (i < 0) break;
+                BulletStore& bs = w.bullets;
+                bs.x[i] = bs.prevX[i] = x;
+                bs.y[i] = bs.prevY[i] = y;
+                bs.vx[i] = e.vx; bs.vy[i] = e.vy;
+                bs.isEnemy[i] = netKind(e.key) == NK_ENEMY_BULLET;
+                bs.damage[i] = 0;
+                bs.col[i] = NET_BULLET_COLORS[e.sub < NET_BULLET_COLOR_COUNT ? e.sub : 0];
+                break;
+            }
+        }
+    }
+    w.bossAlive = !w.enemies.of[ENEMY_BOSS].empty();
+}
+
+// ==================== NET SESSION ====================
+// Two-player co-op over UDP on the local network. --host PORT plays as
+// usual and lets one client in, whoever sends first; --join HOST:PORT
+// runs no sim of its own and flies the wingman. The client samples its
+// controls every SIM_DT into numbered commands, predicts its own jet from
+// them with the host's steerJet, and sends the ones not yet applied each
+// frame. The host applies one per tick and each snapshot says which it
+// got to, so the client resets to the host's jet and replays only the
+// newer ones. Missile, bomb, tap and pause presses are running counters,
+// so a lost packet delays a press but never drops it.
+// Input packet (little endian): u8 'I', u8 protocol, u32 snapshot ack,
+//   u8 count, then count commands, oldest first:
+//   u32 seq, s16 x, s16 y, u8 flags, u8 missiles, u8 bombs, u8 taps, u8 pauses
+const int    NET_INPUT_HISTORY = 128;   // commands kept, power of two
+const int    NET_INPUT_SEND    = 8;     // newest commands per input packet
+const int    NET_INPUT_LAG_MAX = 16;    // host: queued beyond this skips ahead
+const int    NET_CMD_BYTES     = 13;
+const Uint32 NET_TIMEOUT_MS    = 3000;
+const Uint32 NET_KEEPALIVE_MS  = 50;    // outside play, when no ticks are sent
+const int    NET_DEFAULT_PORT  = 40400; // host.on on device
+
+enum { NC_STEER = 1, NC_FIRE = 2 };
+
+struct NetCmd {
+    Uint32 seq;
+    Sint16 x, y;                           // steering point
+    Uint8  flags;                          // NC_*
+    Uint8  missiles, bombs, taps, pauses;  // presses so far, mod 256
+};
+
+template <typename IO, typename C>
+void netCmdIO(IO& io, C& c) {
+    io(c.seq); io(c.x); io(c.y); io(c.flags); io(c.missiles); io(c.bombs); io(c.taps); io(c.pauses);
+}
+
+// Non-blocking IPv4 UDP, the only platform code here
+#ifndef _WIN32
+int netOpenSocket(Uint16 port) {
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s < 0) return -1;
+    sockaddr_in a = {};
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_ANY);
+    a.sin_port = htons(port);
+    if (bind(s, (sockaddr*)&a, sizeof a) != 0 || fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK) != 0) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+bool netResolve(const char* host, Uint32& ip) {
+    addrinfo hints = {}, *res = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host, nullptr, &hints, &res) != 0 || !res) return false;
+    ip = ntohl(((sockaddr_in*)res->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(res);
+    return true;
+}
+
+// Bytes read, or -1 when nothing is waiting
+int netRecvFrom(int s, Uint8* buf, int cap, Uint32& ip, Uint16& port) {
+    sockaddr_in a = {};
+    socklen_t len = sizeof a;
+    ssize_t n = recvfrom(s, buf, cap, 0, (sockaddr*)&a, &len);
+    if (n < 0) return -1;
+    ip = ntohl(a.sin_addr.s_addr);
+    port = ntohs(a.sin_port);
+    return (int)n;
+}
+
+void netSendTo(int s, const Uint8* buf, int n, Uint32 ip, Uint16 port) {
+    sockaddr_in a = {};
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(ip);
+    a.sin_port = htons(port);
+    sendto(s, buf, n, 0, (sockaddr*)&a, sizeof a);
+}
+
+void netCloseSocket(int s) { close(s); }
+#else
+int  netOpenSocket(Uint16)                            { return -1; }
+bool netResolve(const char*, Uint32&)                 { return false; }
+int  netRecvFrom(int, Uint8*, int, Uint32&, Uint16&)  { return -1; }
+void netSendTo(int, const Uint8*, int, Uint32, Uint16) {}
+void netCloseSocket(int)                              {}
+#endif
+
+struct NetSession {
+    bool   hosting  = false;
+    int    sock     = -1;
+    bool   havePeer = false;
+    Uint32 peerIp   = 0;
+    Uint16 peerPort = 0;
+    Uint32 lastHeardMs = 0;
+    Uint32 lastSendMs  = 0;
+    Uint8  packet[NET_PACKET_MAX];
+    
+    // Traffic over the current second, published to World::netStats
+    Uint32 windowMs = 0;
+    int    bytesOut = 0, bytesIn = 0, maxSnapshot = 0, deferred = 0, snapshots = 0;
+    long long totalOut = 0, totalIn = 0;
+    int    peakSnapshot = 0, totalDeferred = 0;
+    
+    // Host
+    NetSender tx;
+    NetCmd    cmds[NET_INPUT_HISTORY];   // received, at seq & (NET_INPUT_HISTORY-1)
+    Uint32    cmdNewest  = 0;
+    Uint32    cmdApplied = 0;
+    NetCmd    applied    = {};           // the last one applied, held while starved
+    Uint8     tapsSeen = 0, pausesSeen = 0;
+    Uint32    lastSentTick = 0;
+    
+    // Client
+    NetReceiver rx;
+    NetCmd      history[NET_INPUT_HISTORY];   // ours, at seq & (NET_INPUT_HISTORY-1)
+    Uint32      cmdSeq = 0;        // newest command made
+    NetCmd      next   = {};       // controls going into the next command
+    Player      self   = {};       // our jet, predicted
+    float       accum  = 0;
+    float       ticksSinceView = 0;
+};
+
+const Uint32 NET_INPUT_MASK = NET_INPUT_HISTORY - 1;
+
+void netSend(NetSession& n, const Uint8* buf, int size) {
+    netSendTo(n.sock, buf, size, n.peerIp, n.peerPort);
+    n.bytesOut += size;
+    n.totalOut += size;
+    n.lastSendMs = SDL_GetTicks();
+}
+
+// Rolls the per-second counters into the world once a second
+void netPublishStats(NetSession& n, World& w) {
+    Uint32 now = SDL_GetTicks();
+    if (now - n.windowMs < 1000) return;
+    NetStats& s = w.netStats;
+    s.bytesOut = n.bytesOut;
+    s.bytesIn = n.bytesIn;
+    s.maxSnapshot = n.maxSnapshot;
+    s.deferred = n.deferred;
+    s.snapshots = n.snapshots;
+    snprintf(s.line, sizeof s.line, "NET %s %.1fK/S IN %.1fK MAX %d DEF %d",
+             n.hosting ? "HOST" : "JOIN", n.bytesOut / 1024.0, n.bytesIn / 1024.0,
+             n.maxSnapshot, n.deferred);
+    n.windowMs = now;
+    n.bytesOut = n.bytesIn = n.maxSnapshot = n.deferred = n.snapshots = 0;
+}
+
+NetSession* netHost(Uint16 port) {
+    int s = netOpenSocket(port);
+    if (s < 0) { SDL_Log("Net: can't listen on UDP port %d", port); return nullptr; }
+    NetSession* n = new NetSession;
+    n->hosting = true;
+    n->sock = s;
+    n->tx.reserve(MAX_BULLETS + MAX_MISSILES + MAX_POWERUPS + 256);
+    SDL_Log("Net: hosting co-op on UDP port %d", port);
+    return n;
+}
+
+NetSession* netJoin(const char* host, Uint16 port) {
+    Uint32 ip = 0;
+    if (!netResolve(host, ip)) { SDL_Log("Net: can't resolve %s", host); return nullptr; }
+    int s = netOpenSocket(0);
+    if (s < 0) { SDL_Log("Net: no UDP socket"); return nullptr; }
+    NetSession* n = new NetSession;
+    n->sock = s;
+    n->havePeer = true;
+    n->peerIp = ip;
+    n->peerPort = port;
+    n->lastHeardMs = SDL_GetTicks();
+    n->rx.reserve(MAX_BULLETS + MAX_MISSILES + MAX_POWERUPS + 256);
+    initPlayer(n->self);
+    SDL_Log("Net: joining %s:%d", host, port);
+    return n;
+}
+
+void netClose(NetSession* n) {
+    if (!n) return;
+    SDL_Log("Net: %lld bytes out, %lld in; largest snapshot %d bytes, %d records deferred",
+            n->totalOut, n->totalIn, n->peakSnapshot, n->totalDeferred);
+    netCloseSocket(n->sock);
+    delete n;
+}
+
+// ---- Host ----
+
+void netApplyCmd(World& g, NetSession& n, const NetCmd& c) {
+    g.wingTouchX = c.x;
+    g.wingTouchY = std::min((int)c.y, PLAY_H);
+    g.wingman.dragging = (c.flags & NC_STEER) != 0;
+    g.wingFire = (c.flags & NC_FIRE) != 0;
+    for (Uint8 i = c.missiles - n.applied.missiles; i > 0; i--) playerFireMissile(g, g.wingman);
+    for (Uint8 i = c.bombs - n.applied.bombs; i > 0; i--) playerBomb(g, g.wingman);
+    n.applied = c;
+}
+
+// Before each tick: the client's next command, if it has arrived
+void netHostTick(World& g, NetSession& n) {
+    if (!n.havePeer || n.cmdNewest <= n.cmdApplied) return;
+    if (n.cmdNewest - n.cmdApplied > NET_INPUT_LAG_MAX) n.cmdApplied = n.cmdNewest - NET_INPUT_LAG_MAX / 2;
+    Uint32 seq = ++n.cmdApplied;
+    const NetCmd& c = n.cmds[seq & NET_INPUT_MASK];
+    if (c.seq == seq) netApplyCmd(g, n, c);
+}
+
+void netHostReceive(World& g, NetSession& n, const Uint8* data, int size, Uint32 ip, Uint16 port) {
+    NetReader nr{ data, data + size };
+    Uint8 type = 0, proto = 0, count = 0;
+    Uint32 ack = 0;
+    nr(type); nr(proto); nr(ack); nr(count);
+    if (!nr.ok || type != PKT_INPUT || proto != NET_PROTOCOL) return;
+    if (!n.havePeer) {
+        n.havePeer = true;
+        n.peerIp = ip;
+        n.peerPort = port;
+        n.cmdNewest = n.cmdApplied = 0;
+        n.applied = {};
+        n.tapsSeen = n.pausesSeen = 0;
+        n.tx.acked = 0;
+        memset(n.cmds, 0, sizeof n.cmds);
+        startCoop(g);
+        SDL_Log("Net: %u.%u.%u.%u:%d joined", ip >> 24, (ip >> 16) & 255, (ip >> 8) & 255, ip & 255, port);
+    } else if (ip != n.peerIp || port != n.peerPort) {
+        return;   // one client at a time
+    }
+    n.lastHeardMs = SDL_GetTicks();
+    n.bytesIn += size;
+    n.totalIn += size;
+    if (ack <= n.tx.seq && ack > n.tx.acked) n.tx.acked = ack;
+    for (int i = 0; i < count && nr.ok; i++) {
+        NetCmd c;
+        netCmdIO(nr, c);
+        if (!nr.ok || c.seq <= n.cmdApplied || c.seq - n.cmdApplied > NET_INPUT_MASK) continue;
+        n.cmds[c.seq & NET_INPUT_MASK] = c;
+        n.cmdNewest = std::max(n.cmdNewest, c.seq);
+    }
+    // Taps and pause don't wait for a tick: outside play there are none
+    const NetCmd& c = n.cmds[n.cmdNewest & NET_INPUT_MASK];
+    if (n.cmdNewest && c.seq == n.cmdNewest) {
+        if (c.taps != n.tapsSeen && g.state != STATE_PLAYING) applyTouch(g, SCREEN_W/2, PLAY_H/2);
+        if (c.pauses != n.pausesSeen) {
+            if (g.state == STATE_PLAYING) g.state = STATE_PAUSED;
+            else if (g.state == STATE_PAUSED) g.state = STATE_PLAYING;
+        }
+        n.tapsSeen = c.taps;
+        n.pausesSeen = c.pauses;
+    }
 }
 
-// ==================== HANDLE INPUT ====================
-bool pointInRect(int x, int y, SDL_Rect& rect) {
-    return x >= rect.x && x <= rect.x+rect.w && y >= rect.y && y <= rect.y+rect.h;
+// Once a frame before the sim steps: input from the client, or its timeout
+void netHostFrame(World& g, NetSession& n) {
+    Uint32 ip; Uint16 port;
+    int size;
+    while ((size = netRecvFrom(n.sock, n.packet, NET_PACKET_MAX, ip, port)) >= 0)
+        netHostReceive(g, n, n.packet, size, ip, port);
+    if (n.havePeer && SDL_GetTicks() - n.lastHeardMs > NET_TIMEOUT_MS) {
+        SDL_Log("Net: client timed out, flying solo");
+        n.havePeer = false;
+        g.coop = false;
+    }
 }
 
-void handleTouch(Game& g, SDL_Event& ev) {
-    int tx, ty;
-    
-    if (ev.type == SDL_FINGERDOWN || ev.type == SDL_FINGERMOTION) {
-        tx = (int)(ev.tfinger.x * SCREEN_W);
-        ty = (int)(ev.tfinger.y * SCREEN_H);
-    } else if (ev.type == SDL_MOUSEBUTTONDOWN || ev.type == SDL_MOUSEMOTION) {
-        tx = ev.button.x;
-        ty = ev.button.y;
-    } else return;
+// Once a frame after the sim steps: at most one snapshot
+void netHostSend(World& g, NetSession& n) {
+    if (n.havePeer) {
+        bool due = g.tick - n.lastSentTick >= (Uint32)NET_SEND_TICKS ||
+                   SDL_GetTicks() - n.lastSendMs >= NET_KEEPALIVE_MS;
+        if (due) {
+            ProfileScope prof(PH_NET);
+            captureNetView(g, n.cmdApplied, n.tx.cur);
+            int deferred = 0;
+            int size = encodeSnapshot(n.tx, n.packet, deferred);
+            netSend(n, n.packet, size);
+            n.lastSentTick = g.tick;
+            n.snapshots++;
+            n.maxSnapshot = std::max(n.maxSnapshot, size);
+            n.peakSnapshot = std::max(n.peakSnapshot, size);
+            n.deferred += deferred;
+            n.totalDeferred += deferred;
+        }
+    }
+    netPublishStats(n, g);
+}
+
+// ---- Client ----
+
+void netClientInput(World& g, NetSession& n, const InputEvent& in, bool playing) {
+    NetCmd& c = n.next;
+    switch (in.type) {
+        case IN_FINGER_DOWN: {
+            Uint8 role = ROLE_NONE;
+            HudButtons b = hudButtons(PLAY_H);
+            if (!playing)                            c.taps++;
+            else if (pointInRect(in.x, in.y, b.fire)) role = ROLE_FIRE;
+            else if (pointInRect(in.x, in.y, b.missile)) c.missiles++;
+            else if (pointInRect(in.x, in.y, b.bomb))    c.bombs++;
+            else if (pointInRect(in.x, in.y, b.pause))   c.pauses++;
+            else if (in.y < PLAY_H) { role = ROLE_STEER; c.x = in.x; c.y = in.y; }
+            g.fingerRole[in.finger] = role;
+            break;
+        }
+        case IN_FINGER_MOVE:
+            if (g.fingerRole[in.finger] == ROLE_STEER) {
+                c.x = in.x;
+                c.y = (Sint16)std::min((int)in.y, PLAY_H);
+            }
+            break;
+        case IN_FINGER_UP: g.fingerRole[in.finger] = ROLE_NONE; break;
+        case IN_MISSILE:   c.missiles++; break;
+        case IN_BOMB:      c.bombs++; break;
+        case IN_PAUSE:     playing ? c.pauses++ : c.taps++; break;
+    }
+    c.flags = (fingerHeld(g, ROLE_STEER) ? NC_STEER : 0) | (fingerHeld(g, ROLE_FIRE) ? NC_FIRE : 0);
+}
+
+void netPredictStep(NetSession& n, const NetCmd& c) {
+    n.self.dragging = (c.flags & NC_STEER) != 0;
+    steerJet(n.self, c.x, std::min((int)c.y, PLAY_H), SIM_DT);
+}
+
+// A new view: take the host's word for our jet, then redo the commands
+// it hasn't applied yet
+void netReconcile(NetSession& n, const NetView& v) {
+    const NetGlobals& g = v.glob;
+    float px = n.self.x, py = n.self.y;
+    applyNetJet(g.jet[1], n.self);
+    if (g.state != STATE_PLAYING || n.self.lives <= 0) return;
+    Uint32 from = std::max(g.ackInput + 1, n.cmdSeq > NET_INPUT_MASK ? n.cmdSeq - NET_INPUT_MASK : 1u);
+    for (Uint32 s = from; s <= n.cmdSeq; s++) netPredictStep(n, n.history[s & NET_INPUT_MASK]);
+    // Draw from where the jet was, so a correction glides in over a tick
+    n.self.prevX = px;
+    n.self.prevY = py;
+}
+
+// The client's whole frame, in place of the sim: input, snapshots,
+// prediction ticks, then the world rebuilt from the newest view
+void netClientFrame(Game& g, NetSession& n, float frameDt) {
+    ProfileScope prof(PH_NET);
+    const Uint32 mask = NET_HISTORY - 1;
+    bool haveView = n.rx.newest != 0;
+    bool playing = haveView && n.rx.views[n.rx.newest & mask].glob.state == STATE_PLAYING;
+    for (const InputEvent& in : g.pendingInput) netClientInput(g, n, in, playing);
+    g.pendingInput.clear();
+    
+    Uint32 ip; Uint16 port;
+    int size;
+    while ((size = netRecvFrom(n.sock, n.packet, NET_PACKET_MAX, ip, port)) >= 0) {
+        if (ip != n.peerIp || port != n.peerPort) continue;
+        n.bytesIn += size;
+        n.totalIn += size;
+        n.maxSnapshot = std::max(n.maxSnapshot, size);
+        n.peakSnapshot = std::max(n.peakSnapshot, size);
+        if (!decodeSnapshot(n.rx, n.packet, size)) continue;
+        n.lastHeardMs = SDL_GetTicks();
+        n.ticksSinceView = 0;
+        const NetView& v = n.rx.views[n.rx.newest & mask];
+        netReconcile(n, v);
+        // Kills happen on the host; a removed enemy still on screen blew up
+        for (const NetEntity& e : n.rx.removed) {
+            if (netKind(e.key) != NK_ENEMY || e.sub >= ENEMY_TYPES) continue;
+            float x = netExtrapolate(e.x, e.vx, v.tick - e.t0) / (float)NET_POS_SCALE;
+            float y = netExtrapolate(e.y, e.vy, v.tick - e.t0) / (float)NET_POS_SCALE;
+            if (y < 0 || y > PLAY_H) continue;
+            const Archetype& a = ARCHETYPES[e.sub];
+            spawnExplosion(g, x, y, a.deathFx, C_FIRE);
+            cueSound(a.boss ? SFX_BIG_EXPLOSION : SFX_EXPLOSION, x);
+        }
+    }
+    if (SDL_GetTicks() - n.lastHeardMs > NET_TIMEOUT_MS && !g.quitRequested) {
+        SDL_Log("Net: lost the host");
+        g.quitRequested = true;
+    }
+    haveView = n.rx.newest != 0;
+    const NetView& v = n.rx.views[n.rx.newest & mask];
+    playing = haveView && v.glob.state == STATE_PLAYING;
+    
+    // Our ticks: a command each, the predicted jet and the cosmetics
+    n.accum += std::min(frameDt, MAX_FRAME_DT);
+    g.dt = SIM_DT;
+    int steps = 0;
+    while (n.accum >= SIM_DT && steps < MAX_SIM_STEPS) {
+        NetCmd& c = n.history[++n.cmdSeq & NET_INPUT_MASK];
+        c = n.next;
+        c.seq = n.cmdSeq;
+        savePrevPositions(g);
+        n.self.prevX = n.self.x;
+        n.self.prevY = n.self.y;
+        if (playing) {
+            tickJetTimers(n.self, SIM_DT);
+            if (n.self.lives > 0) netPredictStep(n, c);
+            jobScroll(g, 0, 0);
+            ageParticles(g.particles, SIM_DT);
+            g.shakeTimer = std::max(0.0f, g.shakeTimer - SIM_DT);
+        }
+        n.ticksSinceView += 1;
+        n.accum -= SIM_DT;
+        steps++;
+    }
+    if (n.accum >= SIM_DT) n.accum = std::fmod(n.accum, SIM_DT);
+    g.renderAlpha = n.accum / SIM_DT;
+    t_prof->simSteps += steps;
+    
+    // The commands the host hasn't confirmed, newest NET_INPUT_SEND of them
+    Uint32 acked = haveView ? v.glob.ackInput : 0;
+    if (steps > 0 || SDL_GetTicks() - n.lastSendMs >= NET_KEEPALIVE_MS) {
+        Uint32 first = std::max(acked + 1, n.cmdSeq >= (Uint32)NET_INPUT_SEND ? n.cmdSeq - NET_INPUT_SEND + 1 : 1u);
+        Uint8 count = (Uint8)(n.cmdSeq >= first ? n.cmdSeq - first + 1 : 0);
+        NetWriter nw{ n.packet };
+        nw(PKT_INPUT); nw(NET_PROTOCOL); nw(n.rx.newest); nw(count);
+        for (Uint32 s = first; s <= n.cmdSeq; s++) netCmdIO(nw, n.history[s & NET_INPUT_MASK]);
+        netSend(n, n.packet, (int)(nw.p - n.packet));
+    }
     
-    if (g.state == STATE_MENU) {
-        g.state = STATE_PLAYING;
-        return;
+    if (haveView) {
+        // Drawn a tick behind like the host's own interpolation, at most
+        // a quarter second ahead of the last view
+        float ahead = std::min(n.ticksSinceView - 1 + g.renderAlpha, (float)SIM_HZ / 4);
+        netViewToWorld(v, ahead, 1, g);
+        g.tick = v.tick;
+        if (playing) {
+            Player& p = g.player;
+            p.x = n.self.x;         p.y = n.self.y;
+            p.prevX = n.self.prevX; p.prevY = n.self.prevY;
+            p.tiltX = n.self.tiltX;
+            p.thrusterAnim = n.self.thrusterAnim;
+        } else {
+            g.player.prevX = g.player.x;
+            g.player.prevY = g.player.y;
+        }
+        g.wingman.prevX = g.wingman.x;
+        g.wingman.prevY = g.wingman.y;
+        g.wingman.thrusterAnim = g.gameTime;
     }
-    if (g.state == STATE_GAMEOVER) {
-        // Restart
-        g.player.score = 0;
-        g.enemies.clear();
-        g.bullets.clear();
-        g.missiles.clear();
-        g.explosions.clear();
-        g.powerups.clear();
-        g.gameTime = 0;
-        g.bossAlive = false;
-        initPlayer(g.player);
-        g.state = STATE_PLAYING;
-        return;
+    netPublishStats(n, g);
+}
+
+// ==================== SIM LOOP ====================
+// Runs as many steps as real time calls for. Returns the number taken.
+int stepSimulation(Game& g, float frameDt) {
+    ProfileScope prof(PH_SIM);
+    g.simAccum += std::min(frameDt, MAX_FRAME_DT);
+    g.dt = SIM_DT;
+    int steps = 0;
+    while (g.simAccum >= SIM_DT && steps < MAX_SIM_STEPS) {
+        pumpInput(g, g.inputLog, g.pendingInput);
+        if (g.state != STATE_PLAYING) break;
+        if (g.net) netHostTick(g, *g.net);
+        updateGame(g);
+        g.simAccum -= SIM_DT;
+        steps++;
+        if (g.state != STATE_PLAYING) break;
     }
-    if (g.state == STATE_PAUSED) {
-        g.state = STATE_PLAYING;
+    t_prof->simSteps += steps;
+    // Too far behind: drop the backlog rather than spiral
+    if (g.simAccum >= SIM_DT) g.simAccum = std::fmod(g.simAccum, SIM_DT);
+    g.renderAlpha = g.simAccum / SIM_DT;
+    return steps;
+}
+
+// One frame of world work: input, sim steps or the game-over clock. Runs
+// on the main thread, or on the sim thread when pipelined.
+void updateFrame(Game& g, float frameDt) {
+    InputEvent in;
+    while (g.inputQueue.pop(in)) g.pendingInput.push_back(in);
+    
+    // A co-op client runs no sim (see NET SESSION)
+    if (g.net && !g.net->hosting) {
+        netClientFrame(g, *g.net, frameDt);
         return;
     }
-    if (g.state != STATE_PLAYING) return;
+    if (g.net) netHostFrame(g, *g.net);
+    
+    // Coming out of the menu or pause the gap since the last frame was
+    // idle time (see MAIN), not time the sim owes
+    float simDt = g.state != STATE_PLAYING ? std::min(frameDt, SIM_DT) : frameDt;
+    
+    // Outside play no ticks run, so input is applied here instead
+    if (g.state != STATE_PLAYING)
+        pumpInput(g, g.inputLog, g.pendingInput);
+    if (g.inputLog.replaying && g.inputLog.ended && !g.quitRequested) {
+        SDL_Log("Replay finished at tick %u", g.tick);
+        g.quitRequested = true;
+    }
     
-    // Button checks
-    if (pointInRect(tx, ty, g.btnFire)) {
-        playerShoot(g);
-        return;
+    GameState prevState = g.state;
+    switch (g.state) {
+        case STATE_MENU:    break;
+        case STATE_PLAYING: stepSimulation(g, simDt); break;
+        case STATE_PAUSED:  break;
+        case STATE_GAMEOVER:
+            g.gameoverTimer += std::min(frameDt, 0.05f);
+            break;
+        default: break;
     }
-    if (pointInRect(tx, ty, g.btnMissile)) {
-        playerFireMissile(g);
-        return;
+    if (prevState == STATE_PLAYING && g.state == STATE_GAMEOVER)
+        logPoolStats(g);
+    if (g.net) netHostSend(g, *g.net);
+}
+
+// ==================== PIPELINE ====================
+// With more than one core the sim runs on its own thread one frame ahead:
+// each frame the main thread kicks it, then draws the newest published
+// World snapshot while the next one is computed. Snapshots go through a
+// lock-free triple buffer, so neither side ever waits for the other; if
+// the sim is late the renderer simply draws the previous snapshot again.
+template <typename T>
+struct TripleBuffer {
+    static const int FRESH = 4;   // flag on `middle`: unread data
+    T                slots[3];
+    std::atomic<int> middle{1};
+    int              back  = 0;  // writer's slot
+    int              front = 2;  // reader's slot
+    
+    T& writeSlot() { return slots[back]; }
+    void publish() { back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & 3; }
+    // Returns the newest published slot; fresh tells whether it changed
+    const T& acquire(bool& fresh) {
+        fresh = (middle.load(std::memory_order_relaxed) & FRESH) != 0;
+        if (fresh) front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+        return slots[front];
+    }
+};
+
+struct FrameSnapshot {
+    World     world;
+    ProfTicks prof;   // sim-thread timings for the frame that produced it
+};
+
+struct Pipeline {
+    Game*                       game   = nullptr;
+    SDL_Thread*                 thread = nullptr;
+    SDL_sem*                    kick   = nullptr;
+    std::atomic<bool>           stop{false};
+    ProfTicks                   simProf;
+    TripleBuffer<FrameSnapshot> snapshots;
+};
+
+void publishSnapshot(Pipeline& pl) {
+    FrameSnapshot& s = pl.snapshots.writeSlot();
+    s.world = *pl.game;   // World part only
+    s.prof  = pl.simProf;
+    pl.simProf = {};
+    pl.snapshots.publish();
+}
+
+int simThreadMain(void* data) {
+    Pipeline& pl = *(Pipeline*)data;
+    t_prof = &pl.simProf;
+    t_traceTid = TRACE_TID_SIM;
+    Uint64 last = SDL_GetPerformanceCounter();
+    double freq = (double)SDL_GetPerformanceFrequency();
+    for (;;) {
+        SDL_SemWait(pl.kick);
+        while (SDL_SemTryWait(pl.kick) == 0) {} // kicks missed while busy fold into one
+        if (pl.stop) break;
+        Uint64 now = SDL_GetPerformanceCounter();
+        float frameDt = (float)((now - last) / freq);
+        last = now;
+        updateFrame(*pl.game, frameDt);
+        publishSnapshot(pl);
+    }
+    return 0;
+}
+
+bool startPipeline(Pipeline& pl, Game& g) {
+    pl.game = &g;
+    publishSnapshot(pl);    // the first frame has something to draw
+    pl.kick = SDL_CreateSemaphore(0);
+    if (!pl.kick) return false;
+    pl.thread = SDL_CreateThread(simThreadMain, "sim", &pl);
+    if (!pl.thread) {
+        SDL_DestroySemaphore(pl.kick);
+        pl.kick = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void stopPipeline(Pipeline& pl) {
+    if (!pl.thread) return;
+    pl.stop = true;
+    SDL_SemPost(pl.kick);
+    SDL_WaitThread(pl.thread, nullptr);
+    SDL_DestroySemaphore(pl.kick);
+    pl.thread = nullptr;
+    pl.kick = nullptr;
+}
+
+#ifndef APEFIGHTER_HEADLESS
+// ==================== AUDIO ====================
+// Every effect is decoded ahead of play: sfx/<name>.wav when the APK
+// ships one, otherwise synthesized from its SOUNDS entry, in the device
+// format either way, so playing is just a Mix_PlayChannel. The bank is
+// built on the warm-up thread; cues before it lands are silent.
+// A fixed pool of voices is shared by priority: a full pool steals the
+// oldest voice of the lowest priority not above the new sound's, and a
+// sound at its voice limit retriggers its own oldest voice.
+//
+// The buffer starts at the smallest size and doubles while the mixer
+// callback keeps arriving late during a short probe, so each device
+// settles on the lowest latency it can hold. --audio-buffer N pins it.
+enum SynthWave : Uint8 { WAVE_SQUARE, WAVE_SINE, WAVE_NOISE };
+
+struct SoundDef {
+    const char* name;
+    Uint8     prio;        // higher steals lower
+    Uint8     maxVoices;
+    Uint8     volume;      // 0..MIX_MAX_VOLUME
+    Uint8     stackVol;    // added per extra cue folded into one voice
+    Uint16    minGapMs;    // closer repeats fold into the playing voice
+    SynthWave wave;
+    float     f0, f1;      // pitch sweep (noise: sample-and-hold rate)
+    float     dur;         // seconds
+};
+
+const SoundDef SOUNDS[SFX_COUNT] = {
+    /* SFX_SHOT          */ { "shot",          1, 2,  28, 0,   0, WAVE_SQUARE, 1400,  600, 0.06f },
+    /* SFX_MISSILE       */ { "missile",       2, 2,  60, 0,   0, WAVE_SQUARE,  300,  900, 0.25f },
+    /* SFX_HIT           */ { "hit",           1, 3,  40, 4,  30, WAVE_NOISE,  6000, 2000, 0.05f },
+    /* SFX_EXPLOSION     */ { "explosion",     3, 4,  80, 8,  60, WAVE_NOISE,  3000,  200, 0.45f },
+    /* SFX_BIG_EXPLOSION */ { "big_explosion", 4, 1, 120, 0,   0, WAVE_NOISE,  2000,   60, 1.20f },
+    /* SFX_BOMB          */ { "bomb",          5, 1, 128, 0,   0, WAVE_NOISE,  1500,   40, 1.50f },
+    /* SFX_BOSS          */ { "boss",          5, 1, 100, 0,   0, WAVE_SQUARE,  110,   80, 1.20f },
+    /* SFX_POWERUP       */ { "powerup",       3, 1,  90, 0,   0, WAVE_SINE,    600, 1200, 0.20f },
+    /* SFX_PLAYER_HIT    */ { "player_hit",    4, 1, 110, 0,   0, WAVE_SQUARE,  200,   80, 0.30f },
+};
+
+const int AUDIO_VOICES      = 16;
+const int AUDIO_FREQ        = 48000;
+const int AUDIO_BUFFERS[]   = { 256, 512, 1024, 2048 };
+const int AUDIO_BUFFER_COUNT = sizeof(AUDIO_BUFFERS) / sizeof(AUDIO_BUFFERS[0]);
+const int AUDIO_PROBE_MS    = 1500;  // watch each buffer size this long
+const int AUDIO_MAX_LATE    = 3;     // late callbacks tolerated per probe
+
+struct Voice {
+    int    sound = -1;
+    Uint8  prio  = 0;
+    Uint64 start = 0;
+};
+
+struct Audio {
+    bool       open     = false;
+    int        freq     = 0;
+    int        channels = 0;
+    int        buffer   = 0;       // index into AUDIO_BUFFERS
+    bool       probing  = false;
+    Uint32     probeStart = 0;
+    Mix_Chunk* chunks[SFX_COUNT] = {};
+    std::vector<Sint16> pcm[SFX_COUNT];   // decoded sample data, in pcmFreq / pcmChannels
+    int        pcmFreq = 0, pcmChannels = 0, pcmFromFile = 0;
+    // The bank being built on the warm-up thread, which owns it while staging
+    bool       staging = false;
+    int        stageFreq = 0, stageChannels = 0, stageFromFile = 0;
+    std::vector<Sint16> stagePcm[SFX_COUNT];
+    Voice      voices[AUDIO_VOICES];
+    Uint64     lastStart[SFX_COUNT] = {};
+    std::atomic<Uint32> busy{0};          // channel bits, cleared when one finishes
+    std::atomic<Uint64> lastMix{0};       // written by the mixer thread
+    std::atomic<int>    late{0};
+    Uint64     lateTicks = 0;             // a callback later than this is late
+    int        played = 0, stolen = 0, folded = 0, dropped = 0;
+};
+
+Audio g_audio;
+
+void audioChannelDone(int ch) {
+    g_audio.busy.fetch_and(~(1u << ch));
+}
+
+// Mixer thread, once per buffer
+void audioPostMix(void*, Uint8*, int) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 prev = g_audio.lastMix.exchange(now);
+    if (prev && now - prev > g_audio.lateTicks) g_audio.late++;
+}
+
+void synthSound(std::vector<Sint16>& out, const SoundDef& d, int freq, int channels) {
+    int frames = (int)(d.dur * freq);
+    out.assign((size_t)frames * channels, 0);
+    Uint32 noise = 0x1234567u;
+    float phase = 0, held = 0;
+    for (int i = 0; i < frames; i++) {
+        float t = (float)i / frames;
+        float f = d.f0 * powf(d.f1 / d.f0, t);          // exponential sweep
+        float env = std::min(1.0f, i / (0.002f * freq)) * (1 - t) * (1 - t);
+        float v;
+        phase += f / freq;
+        if (d.wave == WAVE_NOISE) {
+            if (phase >= 1) {
+                phase -= floorf(phase);
+                noise = noise * 1664525u + 1013904223u;
+                held = (noise >> 8) / (float)(1 << 23) - 1;
+            }
+            v = held;
+        } else {
+            phase -= floorf(phase);
+            v = d.wave == WAVE_SINE ? sinf(phase * 2 * (float)M_PI) : (phase < 0.5f ? 0.6f : -0.6f);
+        }
+        Sint16 sample = (Sint16)(v * env * 30000);
+        for (int c = 0; c < channels; c++) out[(size_t)i * channels + c] = sample;
+    }
+}
+
+// Any thread: a WAV converted to signed 16-bit at freq / channels
+bool decodeSoundFile(const char* path, std::vector<Sint16>& out, int freq, int channels) {
+    SDL_AudioSpec spec;
+    Uint8* buf = nullptr;
+    Uint32 len = 0;
+    if (!SDL_LoadWAV(path, &spec, &buf, &len)) return false;
+    SDL_AudioCVT cvt;
+    bool ok = SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq,
+                                AUDIO_S16SYS, (Uint8)channels, freq) >= 0;
+    if (ok) {
+        std::vector<Uint8> data((size_t)len * std::max(1, cvt.len_mult));
+        memcpy(data.data(), buf, len);
+        cvt.buf = data.data();
+        cvt.len = (int)len;
+        ok = SDL_ConvertAudio(&cvt) == 0;
+        if (ok) out.assign((const Sint16*)data.data(), (const Sint16*)(data.data() + cvt.len_cvt));
+    }
+    SDL_FreeWAV(buf);
+    return ok;
+}
+
+// Warm-up thread: fills the staged bank in the format loadSoundBank asked for
+void buildSoundBank(WarmJob&) {
+    Audio& a = g_audio;
+    a.stageFromFile = 0;
+    for (int i = 0; i < SFX_COUNT; i++) {
+        std::string path = std::string("sfx/") + SOUNDS[i].name + ".wav";
+        if (decodeSoundFile(path.c_str(), a.stagePcm[i], a.stageFreq, a.stageChannels)) a.stageFromFile++;
+        else synthSound(a.stagePcm[i], SOUNDS[i], a.stageFreq, a.stageChannels);
+    }
+}
+
+// Chunks are in the open device's format, so they are rebuilt after a reopen
+void freeSoundBank() {
+    for (int i = 0; i < SFX_COUNT; i++) {
+        if (g_audio.chunks[i]) Mix_FreeChunk(g_audio.chunks[i]);
+        g_audio.chunks[i] = nullptr;
     }
-    if (pointInRect(tx, ty, g.btnBomb)) {
-        playerBomb(g);
+}
+
+void installSoundBank(Game&, WarmJob&);
+
+// Wraps the decoded bank when it is in the device's format, otherwise
+// has it rebuilt off the main thread and leaves the chunks empty meanwhile
+void loadSoundBank() {
+    Audio& a = g_audio;
+    if (a.pcmFreq != a.freq || a.pcmChannels != a.channels) {
+        if (!a.staging) {
+            a.staging = true;
+            a.stageFreq = a.freq;
+            a.stageChannels = a.channels;
+            queueWarmJob(WARM_SOUNDS, buildSoundBank, installSoundBank);
+        }
         return;
     }
-    if (pointInRect(tx, ty, g.btnPause)) {
-        g.state = STATE_PAUSED;
+    for (int i = 0; i < SFX_COUNT; i++)
+        a.chunks[i] = Mix_QuickLoad_RAW((Uint8*)a.pcm[i].data(), (Uint32)(a.pcm[i].size() * sizeof(Sint16)));
+    SDL_Log("Audio: %d sounds (%d from sfx/, %d synthesized)", SFX_COUNT, a.pcmFromFile, SFX_COUNT - a.pcmFromFile);
+}
+
+void installSoundBank(Game&, WarmJob&) {
+    Audio& a = g_audio;
+    freeSoundBank();
+    for (int i = 0; i < SFX_COUNT; i++) {
+        a.pcm[i].swap(a.stagePcm[i]);
+        a.stagePcm[i].clear();
+    }
+    a.pcmFreq = a.stageFreq;
+    a.pcmChannels = a.stageChannels;
+    a.pcmFromFile = a.stageFromFile;
+    a.staging = false;
+    if (a.open) loadSoundBank();
+}
+
+bool openAudioDevice(int buffer) {
+    Audio& a = g_audio;
+    if (Mix_OpenAudio(AUDIO_FREQ, AUDIO_S16SYS, 2, AUDIO_BUFFERS[buffer]) != 0) return false;
+    Uint16 format;
+    Mix_QuerySpec(&a.freq, &format, &a.channels);
+    a.buffer = buffer;
+    a.open = true;
+    Mix_AllocateChannels(AUDIO_VOICES);
+    Mix_ChannelFinished(audioChannelDone);
+    a.busy = 0;
+    for (Voice& v : a.voices) v = Voice();
+    // Late: a callback more than 1.5 buffers after the previous one
+    a.lateTicks = SDL_GetPerformanceFrequency() * AUDIO_BUFFERS[buffer] * 3 / (2 * (Uint64)a.freq);
+    a.lastMix = 0;
+    a.late = 0;
+    a.probeStart = SDL_GetTicks();
+    Mix_SetPostMix(audioPostMix, nullptr);
+    loadSoundBank();
+    return true;
+}
+
+void closeAudioDevice() {
+    Audio& a = g_audio;
+    if (!a.open) return;
+    Mix_SetPostMix(nullptr, nullptr);
+    Mix_HaltChannel(-1);
+    freeSoundBank();
+    Mix_CloseAudio();
+    a.open = false;
+}
+
+// pinnedBuffer: -1 probes from the smallest size, otherwise the frames to use
+bool initAudio(int pinnedBuffer) {
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+        SDL_Log("Audio: %s, running silent", SDL_GetError());
+        return false;
+    }
+    int first = 0;
+    if (pinnedBuffer > 0)
+        while (first + 1 < AUDIO_BUFFER_COUNT && AUDIO_BUFFERS[first] < pinnedBuffer) first++;
+    for (int b = first; b < AUDIO_BUFFER_COUNT; b++) {
+        if (!openAudioDevice(b)) continue;
+        g_audio.probing = pinnedBuffer <= 0 && b + 1 < AUDIO_BUFFER_COUNT;
+        g_soundQueue.enabled = true;
+        SDL_Log("Audio: %d Hz, %d ch, %d-frame buffer%s", g_audio.freq, g_audio.channels,
+                AUDIO_BUFFERS[b], g_audio.probing ? " (probing)" : "");
+        return true;
+    }
+    SDL_Log("Audio: Mix_OpenAudio failed: %s, running silent", Mix_GetError());
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    return false;
+}
+
+void shutdownAudio() {
+    if (!g_audio.open) return;
+    g_soundQueue.enabled = false;
+    SDL_Log("Audio: %d played, %d stolen, %d folded, %d dropped, %d cues lost",
+            g_audio.played, g_audio.stolen, g_audio.folded, g_audio.dropped, g_soundQueue.dropped);
+    closeAudioDevice();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+void playVoice(int id, int volume, int x) {
+    Audio& a = g_audio;
+    const SoundDef& d = SOUNDS[id];
+    if (!a.chunks[id]) return;
+    Uint32 busy = a.busy.load();
+    int freeCh = -1, same = 0, oldestSame = -1, victim = -1;
+    for (int ch = 0; ch < AUDIO_VOICES; ch++) {
+        const Voice& v = a.voices[ch];
+        if (!(busy & (1u << ch))) { if (freeCh < 0) freeCh = ch; continue; }
+        if (v.sound == id) {
+            same++;
+            if (oldestSame < 0 || v.start < a.voices[oldestSame].start) oldestSame = ch;
+        }
+        if (v.prio <= d.prio && (victim < 0 || v.prio < a.voices[victim].prio ||
+                                 (v.prio == a.voices[victim].prio && v.start < a.voices[victim].start)))
+            victim = ch;
+    }
+    int ch = same >= d.maxVoices ? oldestSame : freeCh >= 0 ? freeCh : victim;
+    if (ch < 0) { a.dropped++; return; }
+    if (busy & (1u << ch)) {
+        Mix_HaltChannel(ch);
+        if (a.voices[ch].sound != id) a.stolen++;
+    }
+    // Busy before playing: a short sound may finish before Mix_PlayChannel returns
+    a.busy.fetch_or(1u << ch);
+    a.voices[ch] = { id, d.prio, SDL_GetPerformanceCounter() };
+    int pan = 64 + std::max(0, std::min(x, SCREEN_W)) * 127 / SCREEN_W;
+    Mix_SetPanning(ch, (Uint8)std::min(255, 2 * (255 - pan)), (Uint8)std::min(255, 2 * pan));
+    Mix_Volume(ch, std::min(volume, MIX_MAX_VOLUME));
+    if (Mix_PlayChannel(ch, a.chunks[id], 0) < 0) {
+        a.busy.fetch_and(~(1u << ch));
+        a.dropped++;
         return;
     }
+    a.lastStart[id] = a.voices[ch].start;
+    a.played++;
+}
+
+// Main thread, once per frame: plays this frame's cues, one voice per
+// sound, and finishes the buffer-size probe
+void updateAudio() {
+    Audio& a = g_audio;
+    if (!a.open) return;
+    
+    int count[SFX_COUNT] = {};
+    int xsum[SFX_COUNT]  = {};
+    SoundCue c;
+    while (g_soundQueue.pop(c)) {
+        count[c.id]++;
+        xsum[c.id] += c.x;
+    }
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 perMs = SDL_GetPerformanceFrequency() / 1000;
+    for (int id = 0; id < SFX_COUNT; id++) {
+        if (!count[id]) continue;
+        const SoundDef& d = SOUNDS[id];
+        if (a.lastStart[id] && now - a.lastStart[id] < d.minGapMs * perMs) {
+            a.folded += count[id];
+            continue;
+        }
+        a.folded += count[id] - 1;
+        playVoice(id, d.volume + d.stackVol * (count[id] - 1), xsum[id] / count[id]);
+    }
     
-    // Move player
-    if (ty < PLAY_H) {
-        g.touchX = tx;
-        g.touchY = ty;
-        g.player.dragging = true;
+    if (a.probing && SDL_GetTicks() - a.probeStart > (Uint32)AUDIO_PROBE_MS) {
+        int late = a.late;
+        if (late <= AUDIO_MAX_LATE) {
+            a.probing = false;
+            SDL_Log("Audio: settled on %d frames (%.1f ms)", AUDIO_BUFFERS[a.buffer],
+                    1000.0f * AUDIO_BUFFERS[a.buffer] / a.freq);
+            return;
+        }
+        int next = a.buffer + 1;
+        SDL_Log("Audio: %d late callbacks at %d frames, trying %d", late, AUDIO_BUFFERS[a.buffer], AUDIO_BUFFERS[next]);
+        closeAudioDevice();
+        if (!openAudioDevice(next)) {
+            SDL_Log("Audio: reopen failed: %s, running silent", Mix_GetError());
+            g_soundQueue.enabled = false;
+            return;
+        }
+        a.probing = next + 1 < AUDIO_BUFFER_COUNT;
+    }
+}
+#endif // APEFIGHTER_HEADLESS
+
+// ==================== HEADLESS BENCH ====================
+// Built with -DAPEFIGHTER_HEADLESS: runs updateGame for a fixed number of
+// SIM_DT ticks with a fixed seed and scripted input, without a window or
+// renderer, and reports throughput, pool peaks, heap allocations during
+// the run and per-phase sim time. The state hash at the end should only
+// change when gameplay does.
+#ifdef APEFIGHTER_HEADLESS
+// Counted from every thread the bench runs (sim and job helpers)
+std::atomic<size_t> g_allocCount{0}, g_allocBytes{0};
+
+// Out of line: inlined into a caller, GCC pairs the new with the free
+// underneath and warns -Wmismatched-new-delete
+#ifdef __GNUC__
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+BENCH_NOINLINE void* operator new(size_t n) {
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+BENCH_NOINLINE void operator delete(void* p) noexcept { free(p); }
+BENCH_NOINLINE void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Drags the jet in a slow figure-eight (auto-fire is on while dragging)
+// and fires a missile every 2s and a bomb every 20s
+void benchInputWeave(World& w, int tick) {
+    float t = tick * SIM_DT;
+    w.player.dragging = true;
+    w.touchX = (int)(SCREEN_W * 0.5f + sinf(t * 1.3f) * 250);
+    w.touchY = (int)(PLAY_H - 250 + sinf(t * 2.6f) * 120);
+    if (tick % (2 * SIM_HZ) == 0)  playerFireMissile(w, w.player);
+    if (tick % (20 * SIM_HZ) == 0) playerBomb(w, w.player);
+}
+
+void benchInputIdle(World& w, int /*tick*/) {
+    w.player.dragging = false;
+}
+
+struct BenchScenario {
+    const char* name;
+    float startTime;    // gameTime at tick 0: mixed enemies after 30/60s, boss after 90s
+    bool  rapidFire;    // kept on for the whole run
+    bool  god;          // HP and lives restored every tick so the run always completes
+    void (*input)(World&, int tick);
+};
+
+const BenchScenario BENCH_SCENARIOS[] = {
+    { "idle",       0.0f,   false, true, benchInputIdle  },
+    { "early",      0.0f,   false, true, benchInputWeave },
+    { "mixed",      65.0f,  false, true, benchInputWeave },
+    { "boss-rapid", 120.0f, true,  true, benchInputWeave },
+};
+
+// Floats go in as their bits: any divergence at all changes the hash,
+// not just one that has grown past a pixel by the last tick
+Uint64 hashWorld(const World& w) {
+    Uint64 h = 1469598103934665603ull; // FNV-1a
+    auto mix = [&h](Uint64 v) { for (int i = 0; i < 8; i++) { h ^= (v >> (i*8)) & 0xFF; h *= 1099511628211ull; } };
+    auto mixF = [&mix](float f) { Uint32 u; memcpy(&u, &f, 4); mix(u); };
+    auto mixRng = [&mix](const Rng& r) { for (Uint32 s : r.s) mix(s); };
+    auto mixJet = [&](const Player& p) {
+        mix(p.score); mix(p.kills); mix(p.level); mix(p.hp); mix(p.ammo); mix(p.bombs);
+        mix(p.lives); mix(p.shield); mix(p.rapidFire);
+        mixF(p.x); mixF(p.y); mixF(p.shootTimer); mixF(p.invTimer);
+    };
+    mixJet(w.player);
+    if (w.coop) mixJet(w.wingman);
+    mix(w.tick); mixF(w.gameTime);
+    mixRng(w.rng); mixRng(w.fxRng);
+    
+    mix(w.enemies.size()); mix(w.bullets.size()); mix(w.missiles.size()); mix(w.powerups.size());
+    forEachBySpawn(w.enemies, [&](int, const EnemyJet& e) {
+        mixF(e.x); mixF(e.y); mix(e.hp);
+    });
+    const BulletStore& bs = w.bullets;
+    for (int i = 0; i < bs.top; i++) {
+        if (!bs.alive[i]) continue;
+        mixF(bs.x[i]); mixF(bs.y[i]); mixF(bs.vx[i]); mixF(bs.vy[i]); mix(bs.isEnemy[i]);
+    }
+    for (const Missile& m : w.missiles) { mixF(m.x); mixF(m.y); mixF(m.vx); mixF(m.vy); mixF(m.life); }
+    for (const PowerUp& pu : w.powerups) { mixF(pu.x); mixF(pu.y); mix(pu.type); }
+    for (const Star& st : w.stars) { mixF(st.x); mixF(st.y); }
+    
+    const WaveSchedule& ws = w.waves;
+    mix(ws.tick); mix(ws.genTick); mix(ws.count);
+    mixF(ws.genTime); mixF(ws.enemyTimer); mixF(ws.powerupTimer);
+    for (int i = 0; i < ws.count; i++) {
+        const WaveEntry& e = ws.queue[(ws.head + i) % WAVE_QUEUE];
+        mix(e.tick); mix(e.kind); mix(e.types);
+    }
+    return h;
+}
+
+void reportRun(const char* name, const World& w, int ticks, Uint64 elapsed, int peakEnemies,
+               size_t allocs, size_t allocBytes) {
+    double freq = (double)SDL_GetPerformanceFrequency();
+    double ms = elapsed * 1000.0 / freq;
+    printf("%-10s %d ticks in %.1f ms: %.0f ticks/s, %.2f us/tick\n",
+           name, ticks, ms, ticks / (ms / 1000.0), ms * 1000.0 / std::max(ticks, 1));
+    printf("  peak: bullets %d/%d missiles %d/%d particles %d/%d powerups %d/%d enemies %d\n",
+           w.bullets.peak, MAX_BULLETS, w.missiles.peak, MAX_MISSILES,
+           w.particles.peak, MAX_PARTICLES, w.powerups.peak, MAX_POWERUPS, peakEnemies);
+    printf("  dropped: bullets %d missiles %d particles %d powerups %d\n",
+           w.bullets.dropped, w.missiles.dropped, w.particles.dropped, w.powerups.dropped);
+    printf("  particles: %d merged, %d sparks thinned\n", w.particles.merged, w.particles.thinned);
+    printf("  allocs during run: %zu (%zu bytes)\n", allocs, allocBytes);
+    printf("  phases (ms):");
+    for (int i = PH_SIM; i <= PH_POWERUPS; i++)
+        printf(" %s %.1f", PROF_PHASE_NAMES[i], g_prof.frame.ticks[i] * 1000.0 / freq);
+    printf("\n  score %d kills %d level %d hash %016llx\n",
+           w.player.score, w.player.kills, w.player.level, (unsigned long long)hashWorld(w));
+}
+
+// --net: every NET_SEND_TICKS the world goes through the co-op snapshot
+// codec over a lossless loopback whose acks lag NET_BENCH_ACK_LAG
+// snapshots (~50 ms). Each decoded view must equal the one the host
+// thinks the client holds; drift is how far the client's extrapolated
+// records are from the real positions.
+const int NET_BENCH_ACK_LAG = 3;
+
+struct BenchNet {
+    NetSender   tx;
+    NetReceiver rx;
+    Uint8       packet[NET_PACKET_MAX];
+    long long   bytes = 0;
+    int         snapshots = 0, maxBytes = 0, deferred = 0, mismatched = 0, rejected = 0;
+    float       maxDrift = 0;   // px
+};
+
+bool sameNetEntity(const NetEntity& a, const NetEntity& b) {
+    return a.key == b.key && a.sub == b.sub && a.x == b.x && a.y == b.y &&
+           a.vx == b.vx && a.vy == b.vy && a.hp == b.hp && a.t0 == b.t0;
+}
+
+bool sameNetView(const NetView& a, const NetView& b) {
+    Uint8 ga[NET_GLOBAL_BYTES], gb[NET_GLOBAL_BYTES];
+    NetWriter wa{ ga }, wb{ gb };
+    netGlobalsIO(wa, a.glob);
+    netGlobalsIO(wb, b.glob);
+    if (a.seq != b.seq || a.tick != b.tick || memcmp(ga, gb, sizeof ga) || a.ents.size() != b.ents.size())
+        return false;
+    for (size_t i = 0; i < a.ents.size(); i++)
+        if (!sameNetEntity(a.ents[i], b.ents[i])) return false;
+    return true;
+}
+
+void benchNetStep(BenchNet& bn, const World& w) {
+    const Uint32 mask = NET_HISTORY - 1;
+    captureNetView(w, 0, bn.tx.cur);
+    int deferred = 0;
+    int n = encodeSnapshot(bn.tx, bn.packet, deferred);
+    bn.bytes += n;
+    bn.snapshots++;
+    bn.maxBytes = std::max(bn.maxBytes, n);
+    bn.deferred += deferred;
+    if (!decodeSnapshot(bn.rx, bn.packet, n)) { bn.rejected++; return; }
+    const NetView& got = bn.rx.views[bn.rx.newest & mask];
+    if (!sameNetView(got, bn.tx.sent[bn.tx.seq & mask])) bn.mismatched++;
+    
+    const NetView& cur = bn.tx.cur;
+    for (size_t i = 0, j = 0; i < got.ents.size() && j < cur.ents.size();) {
+        const NetEntity& e = got.ents[i];
+        if (e.key < cur.ents[j].key) { i++; continue; }
+        if (cur.ents[j].key < e.key) { j++; continue; }
+        float dx = (float)(netExtrapolate(e.x, e.vx, cur.tick - e.t0) - cur.ents[j].x);
+        float dy = (float)(netExtrapolate(e.y, e.vy, cur.tick - e.t0) - cur.ents[j].y);
+        bn.maxDrift = std::max(bn.maxDrift, std::max(fabsf(dx), fabsf(dy)) / NET_POS_SCALE);
+        i++; j++;
+    }
+    if (bn.rx.newest > (Uint32)NET_BENCH_ACK_LAG) bn.tx.acked = bn.rx.newest - NET_BENCH_ACK_LAG;
+}
+
+void reportNet(const BenchNet& bn) {
+    double perSnap = (double)bn.bytes / std::max(bn.snapshots, 1);
+    printf("  net: %d snapshots, %.0f bytes avg, %d max, %.1f KB/s, %d records deferred, "
+           "max drift %.2f px, %d mismatched, %d rejected\n",
+           bn.snapshots, perSnap, bn.maxBytes, perSnap * SIM_HZ / NET_SEND_TICKS / 1024.0,
+           bn.deferred, bn.maxDrift, bn.mismatched, bn.rejected);
+}
+
+// resume: halfway through, round-trip the world through a suspend
+// snapshot into a fresh one (other seed) and carry on with that; the final
+// hash must match a straight run
+void runBench(const BenchScenario& sc, int ticks, Uint64 seed, float density, bool resume, bool net) {
+    std::unique_ptr<World> wp(new World());
+    World& w = *wp;
+    initWorld(w, seed);
+    w.state    = STATE_PLAYING;
+    w.gameTime = sc.startTime;
+    w.dt       = SIM_DT;
+    w.waves.density = density;
+    resetWaves(w);
+    std::unique_ptr<BenchNet> bn;
+    if (net) {
+        bn.reset(new BenchNet());
+        bn->tx.reserve(MAX_BULLETS + MAX_MISSILES + MAX_POWERUPS + 256);
+        bn->rx.reserve(MAX_BULLETS + MAX_MISSILES + MAX_POWERUPS + 256);
+    }
+    
+    g_prof.frame = {};
+    size_t peakEnemies = 0;
+    size_t allocs0 = g_allocCount, bytes0 = g_allocBytes;
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    int tick = 0;
+    for (; tick < ticks && w.state == STATE_PLAYING; tick++) {
+        if (resume && tick == ticks / 2) {
+            std::vector<Uint8> snap;
+            writeSnapshot(w, snap);
+            std::unique_ptr<World> fresh(new World());
+            initWorld(*fresh, seed + 1);
+            if (!readSnapshot(*fresh, snap.data(), snap.size())) {
+                printf("%-10s snapshot did not read back\n", sc.name);
+                return;
+            }
+            fresh->state = STATE_PLAYING;   // restores come back paused
+            w = *fresh;
+            printf("%-10s resumed from a %d byte snapshot at tick %d\n", sc.name, (int)snap.size(), tick);
+        }
+        sc.input(w, tick);
+        if (sc.rapidFire) { w.player.rapidFire = true; w.player.rapidTimer = 8.0f; }
+        {
+            ProfileScope prof(PH_SIM);
+            updateGame(w);
+        }
+        if (sc.god) {
+            w.player.hp = w.player.maxHp;
+            w.player.lives = 3;
+            w.state = STATE_PLAYING;
+        }
+        if (bn && w.tick % NET_SEND_TICKS == 0) benchNetStep(*bn, w);
+        peakEnemies = std::max(peakEnemies, w.enemies.size());
+    }
+    reportRun(sc.name, w, tick, SDL_GetPerformanceCounter() - t0, (int)peakEnemies,
+              g_allocCount - allocs0, g_allocBytes - bytes0);
+    if (bn) reportNet(*bn);
+}
+
+// Replays a recording from the renderer build through the bare sim
+int runReplay(const char* path, int maxTicks) {
+    InputLog log;
+    Uint64 seed = 0;
+    if (!openReplay(log, path, seed)) return 1;
+    std::unique_ptr<World> wp(new World());
+    World& w = *wp;
+    initWorld(w, seed);
+    w.dt = SIM_DT;
+    std::vector<InputEvent> live; // stays empty
+    
+    g_prof.frame = {};
+    size_t peakEnemies = 0;
+    size_t allocs0 = g_allocCount, bytes0 = g_allocBytes;
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    while (!log.ended && (int)w.tick < maxTicks) {
+        pumpInput(w, log, live);
+        if (log.ended) break;
+        if (w.state != STATE_PLAYING) {
+            // Ticks only advance in play; nothing else can unblock the replay
+            printf("replay stalled at tick %u outside play\n", w.tick);
+            break;
+        }
+        {
+            ProfileScope prof(PH_SIM);
+            updateGame(w);
+        }
+        peakEnemies = std::max(peakEnemies, w.enemies.size());
     }
+    reportRun("replay", w, (int)w.tick, SDL_GetPerformanceCounter() - t0, (int)peakEnemies,
+              g_allocCount - allocs0, g_allocBytes - bytes0);
+    closeInputLog(log, w.tick);
+    return 0;
 }
 
-void handleTouchUp(Game& g) {
-    g.player.dragging = false;
+int main(int argc, char* argv[]) {
+    int ticks = 0;  // default: 60s per scenario, a replay runs to its end
+    Uint64 seed = 12345;
+    const char* replayPath = nullptr;
+    int workers = -1;
+    float density = 1.0f;
+    bool resume = false, net = false;
+    std::vector<const BenchScenario*> run;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--ticks") && i + 1 < argc)      ticks = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--workers") && i + 1 < argc) workers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--density") && i + 1 < argc) density = std::max(0.1f, (float)atof(argv[++i]));
+        else if (!strcmp(argv[i], "--replay") && i + 1 < argc) replayPath = argv[++i];
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)  seed = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc) startTrace(argv[++i]);
+        else if (!strcmp(argv[i], "--resume-check")) resume = true;
+        else if (!strcmp(argv[i], "--net")) net = true;
+        else {
+            const BenchScenario* found = nullptr;
+            for (const BenchScenario& sc : BENCH_SCENARIOS)
+                if (!strcmp(argv[i], sc.name)) found = &sc;
+            if (!found) {
+                fprintf(stderr, "unknown scenario '%s'; available:", argv[i]);
+                for (const BenchScenario& sc : BENCH_SCENARIOS) fprintf(stderr, " %s", sc.name);
+                fprintf(stderr, "\n");
+                return 2;
+            }
+            run.push_back(found);
+        }
+    }
+    // No render thread here, so one more helper than on device by default
+    initJobs(workers >= 0 ? workers : std::max(0, std::min(SDL_GetCPUCount() - 1, JOB_MAX_WORKERS)));
+    int rc = 0;
+    if (replayPath) {
+        rc = runReplay(replayPath, ticks > 0 ? ticks : INT32_MAX);
+    } else {
+        if (ticks <= 0) ticks = 60 * SIM_HZ;
+        if (run.empty())
+            for (const BenchScenario& sc : BENCH_SCENARIOS) run.push_back(&sc);
+        
+        printf("seed %llu, %d ticks at %d Hz, %d job threads, spawn density %.2f\n",
+               (unsigned long long)seed, ticks, SIM_HZ, g_jobs.workers, density);
+        for (const BenchScenario* sc : run) runBench(*sc, ticks, seed, density, resume, net);
+    }
+    shutdownJobs();
+    saveTrace("bench");   // sim phases of the last ~5000 ticks
+    return rc;
 }
 
+#else
 // ==================== MAIN ====================
+// Outside play (menu, pause, game over) frames are paced by
+// SDL_WaitEventTimeout: menu animations run at IDLE_FPS (--idle-fps N),
+// the paused frame only refreshes every PAUSE_REDRAW_MS, and any input
+// brings back full rate for IDLE_GRACE_MS so taps respond at once.
+const int    IDLE_FPS        = 20;
+const Uint32 PAUSE_REDRAW_MS = 500;
+const Uint32 IDLE_GRACE_MS   = 250;
+
 int main(int argc, char* argv[]) {
-    srand((unsigned)time(nullptr));
+    g_warm.launch = SDL_GetPerformanceCounter();   // startup times count from here (see WARM-UP)
+    Uint64 seed = (Uint64)time(nullptr) ^ SDL_GetPerformanceCounter();
     
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) != 0) {
         SDL_Log("SDL_Init failed: %s", SDL_GetError());
@@ -1514,7 +6297,6 @@ int main(int argc, char* argv[]) {
     }
     
     Game game;
-    g_game = &game;
     
     // Create window - fullscreen for mobile
     game.window = SDL_CreateWindow(
@@ -1537,105 +6319,295 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    // Scale to fit Oppo A5 5G screen
-    SDL_RenderSetLogicalSize(game.renderer, SCREEN_W, SCREEN_H);
+    // Logical height from the display's aspect ratio (a replay may override)
+    int winW = 0, winH = 0;
+    SDL_GetWindowSize(game.window, &winW, &winH);
+    if (winW > 0 && winH > 0) setLayout((int)lroundf(SCREEN_W * (float)winH / winW));
     SDL_SetRenderDrawBlendMode(game.renderer, SDL_BLENDMODE_BLEND);
     
-    // Init game objects
-    initPlayer(game.player);
-    initStars(game.stars);
-    initClouds(game.clouds);
-    initMountains(game.mountains);
+    // Input recording / replay: --record PATH / --replay PATH, or on
+    // device a replay.afr (replayed) or record.on (records to record.afr)
+    // in the app's pref path
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* tracePath  = nullptr;
+    const char* joinAddr   = nullptr;
+    int hostPort = 0;
+    bool singleThread = SDL_GetCPUCount() < 2;
+    int quality = -1;
+    int audioBuffer = -1;   // 0: no audio
+    int idleFps = IDLE_FPS;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--single-thread")) singleThread = true;
+        else if (!strcmp(argv[i], "--mute")) audioBuffer = 0;
+        else if (i + 1 >= argc) break;
+        else if (!strcmp(argv[i], "--quality")) quality = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--audio-buffer")) audioBuffer = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--idle-fps")) idleFps = std::max(1, std::min(atoi(argv[++i]), 60));
+        else if (!strcmp(argv[i], "--touch-predict"))
+            game.touch.predictMs = std::max(0, std::min(atoi(argv[++i]), 50));
+        else if (!strcmp(argv[i], "--play-scale"))
+            g_quality.playScaleOverride = std::max(0.25f, std::min((float)atof(argv[++i]), 1.0f));
+        else if (!strcmp(argv[i], "--record")) recordPath = argv[++i];
+        else if (!strcmp(argv[i], "--replay")) replayPath = argv[++i];
+        else if (!strcmp(argv[i], "--trace")) tracePath = argv[++i];
+        else if (!strcmp(argv[i], "--host")) hostPort = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--join")) joinAddr = argv[++i];
+    }
+
+    std::string prefDir;
+    if (char* pref = SDL_GetPrefPath("apefighter", "ApeFighter")) {
+        prefDir = pref;
+        SDL_free(pref);
+    }
+    auto prefExists = [&](const char* name) {
+        SDL_RWops* f = prefDir.empty() ? nullptr : SDL_RWFromFile((prefDir + name).c_str(), "rb");
+        if (f) SDL_RWclose(f);
+        return f != nullptr;
+    };
+    // Field traces: trace.on in the pref path records to trace.json
+    std::string prefTrace = prefDir + "trace.json";
+    if (!tracePath && prefExists("trace.on")) tracePath = prefTrace.c_str();
+    if (tracePath) startTrace(tracePath);
+    
+    // Co-op: --host PORT / --join HOST:PORT, or on device host.on (hosts
+    // on NET_DEFAULT_PORT) or join.txt holding HOST:PORT in the pref path
+    std::string joinTarget = joinAddr ? joinAddr : "";
+    if (!hostPort && joinTarget.empty()) {
+        if (prefExists("host.on")) {
+            hostPort = NET_DEFAULT_PORT;
+        } else if (SDL_RWops* f = prefDir.empty() ? nullptr : SDL_RWFromFile((prefDir + "join.txt").c_str(), "rb")) {
+            char buf[64] = {};
+            SDL_RWread(f, buf, 1, sizeof buf - 1);
+            SDL_RWclose(f);
+            joinTarget = buf;
+            joinTarget.erase(joinTarget.find_last_not_of(" \r\n\t") + 1);
+        }
+    }
+    if (hostPort > 0 && hostPort < 65536) {
+        game.net = netHost((Uint16)hostPort);
+    } else if (!joinTarget.empty()) {
+        size_t colon = joinTarget.rfind(':');
+        int port = colon == std::string::npos ? 0 : atoi(joinTarget.c_str() + colon + 1);
+        if (port > 0 && port < 65536) game.net = netJoin(joinTarget.substr(0, colon).c_str(), (Uint16)port);
+        else SDL_Log("Co-op: join wants HOST:PORT, not '%s'", joinTarget.c_str());
+    }
+    std::string prefReplay = prefDir + "replay.afr", prefRecord = prefDir + "record.afr";
+    if (!recordPath && !replayPath && !game.net) {
+        if (prefExists("replay.afr"))     replayPath = prefReplay.c_str();
+        else if (prefExists("record.on")) recordPath = prefRecord.c_str();
+    }
+    // A recording only holds local input, and a client's world is not a sim
+    if (game.net && (recordPath || replayPath)) {
+        SDL_Log("Co-op: not recording or replaying");
+        recordPath = replayPath = nullptr;
+    }
+    initQuality(game.window, quality);
+    if (audioBuffer != 0) initAudio(audioBuffer);
+    
+    if (replayPath) openReplay(game.inputLog, replayPath, seed);
+    else if (recordPath) openRecording(game.inputLog, recordPath, seed);
+    
+    // Scale the logical layout to fit the screen
+    SDL_RenderSetLogicalSize(game.renderer, SCREEN_W, SCREEN_H);
+    SDL_Log("Layout %dx%d on a %dx%d window", SCREEN_W, SCREEN_H, winW, winH);
+    
+    // Init game objects; a run saved on the way into the background comes
+    // back paused (not over a replay or recording: their input starts at
+    // tick 0 of a fresh world, nor in co-op)
+    initWorld(game, seed);
+    game.renderRng.seed(seed, RNG_RENDER);
+    std::string suspendPath = prefDir + "suspend.afs", highScorePath = prefDir + "highscore";
+    bool canSuspend = !prefDir.empty() && !game.inputLog.rw && !game.net;
+    if (canSuspend) loadSuspend(game, suspendPath);
+    int savedHighScore = prefDir.empty() ? 0 : loadHighScore(highScorePath);
+    game.highScore = std::max(game.highScore, savedHighScore);
+    
+    initJobs();
+    
+    // Heap allocated: three World snapshots are too big for the stack
+    Pipeline* pipe = nullptr;
+    if (!singleThread) {
+        pipe = new Pipeline;
+        if (!startPipeline(*pipe, game)) {
+            SDL_Log("Sim thread failed (%s), running single-threaded", SDL_GetError());
+            delete pipe;
+            pipe = nullptr;
+        }
+    }
+    SDL_Log("Update/render: %s", pipe ? "pipelined" : "single thread");
     
-    game.lastTime = SDL_GetTicks();
+    game.lastCounter = SDL_GetPerformanceCounter();
+    const double counterFreq = (double)SDL_GetPerformanceFrequency();
     
-    // HUD button rects (initial, updated in drawHUD)
-    game.btnFire    = { SCREEN_W-130, PLAY_H+80, 100, 60 };
-    game.btnMissile = { SCREEN_W-260, PLAY_H+90,  80, 50 };
-    game.btnBomb    = {  20, PLAY_H+90,  80, 50 };
-    game.btnPause   = { SCREEN_W/2-30, PLAY_H+88, 60, 40 };
+    // Idle pacing (see the top of the loop)
+    GameState shownState = STATE_MENU;
+    Uint32 lastFrameMs = 0, lastInputMs = 0;
+    Uint32 idleWaitMs = 0;
+    int idleFrames = 0;
     
     bool running = true;
+    bool suspendDue = false;   // save the world shown this frame
     SDL_Event ev;
+    auto handleEvent = [&](SDL_Event& ev) {
+        lastInputMs = SDL_GetTicks();
+        switch (ev.type) {
+            case SDL_QUIT:
+                running = false;
+                break;
+            case SDL_APP_WILLENTERBACKGROUND:
+                suspendDue = canSuspend;
+                if (shownState == STATE_PLAYING) queueInput(game, IN_PAUSE);
+                break;
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET:
+                game.cachesDirty = true;
+                break;
+            case SDL_KEYDOWN:
+                if (ev.key.keysym.sym == SDLK_ESCAPE) running = false;
+                if (ev.key.keysym.sym == SDLK_F3) g_prof.show = !g_prof.show;
+                if (ev.key.keysym.sym == SDLK_F4) saveTrace("F4");
+                if (ev.key.keysym.sym == SDLK_SPACE) queueInput(game, IN_SHOOT);
+                if (ev.key.keysym.sym == SDLK_m)     queueInput(game, IN_MISSILE);
+                if (ev.key.keysym.sym == SDLK_b)     queueInput(game, IN_BOMB);
+                if (ev.key.keysym.sym == SDLK_p)     queueInput(game, IN_PAUSE);
+                break;
+            case SDL_FINGERDOWN:
+                // Three-finger tap toggles the profiler overlay
+                if (SDL_GetNumTouchFingers(ev.tfinger.touchId) >= 3) {
+                    g_prof.show = !g_prof.show;
+                    break;
+                }
+                handleTouch(game, ev);
+                break;
+            case SDL_FINGERMOTION:
+            case SDL_FINGERUP:
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP:
+            case SDL_MOUSEMOTION:
+                handleTouch(game, ev);
+                break;
+        }
+    };
     
     while (running) {
-        // Delta time
-        Uint32 now = SDL_GetTicks();
-        game.dt = (now - game.lastTime) / 1000.0f;
-        if (game.dt > 0.05f) game.dt = 0.05f; // cap at 20fps min
-        game.lastTime = now;
-        game.menuAnim += game.dt;
+        // Idle: outside play, and a moment after the last input, block on
+        // events until the next (low-rate) frame is due instead of
+        // redrawing every vsync (not while caches are still landing)
+        if (shownState != STATE_PLAYING && !game.quitRequested && !warmupPending() &&
+            SDL_GetTicks() - lastInputMs > IDLE_GRACE_MS) {
+            Uint32 frameMs = shownState == STATE_PAUSED ? PAUSE_REDRAW_MS : 1000 / idleFps;
+            int waitMs = (int)(lastFrameMs + frameMs - SDL_GetTicks());
+            if (waitMs > 0) {
+                Uint32 waitStart = SDL_GetTicks();
+                if (SDL_WaitEventTimeout(&ev, waitMs)) handleEvent(ev);
+                idleWaitMs += SDL_GetTicks() - waitStart;
+            }
+            idleFrames++;
+        }
+        lastFrameMs = SDL_GetTicks();
+        
+        // Frame time (the sim steps at SIM_DT regardless)
+        Uint64 now = SDL_GetPerformanceCounter();
+        float frameDt = (float)((now - game.lastCounter) / counterFreq);
+        float animDt  = std::min(frameDt, 0.05f); // cap at 20fps min for UI animation
+        game.lastCounter = now;
+        game.menuAnim += animDt;
         
         // Events
-        while (SDL_PollEvent(&ev)) {
-            switch (ev.type) {
-                case SDL_QUIT:
-                    running = false;
-                    break;
-                case SDL_KEYDOWN:
-                    if (ev.key.keysym.sym == SDLK_ESCAPE) running = false;
-                    if (ev.key.keysym.sym == SDLK_SPACE && game.state == STATE_PLAYING)
-                        playerShoot(game);
-                    if (ev.key.keysym.sym == SDLK_m && game.state == STATE_PLAYING)
-                        playerFireMissile(game);
-                    if (ev.key.keysym.sym == SDLK_b && game.state == STATE_PLAYING)
-                        playerBomb(game);
-                    if (ev.key.keysym.sym == SDLK_p) {
-                        if (game.state == STATE_PLAYING) game.state = STATE_PAUSED;
-                        else if (game.state == STATE_PAUSED) game.state = STATE_PLAYING;
-                    }
-                    break;
-                case SDL_FINGERDOWN:
-                case SDL_FINGERMOTION:
-                    handleTouch(game, ev);
-                    break;
-                case SDL_FINGERUP:
-                    handleTouchUp(game);
-                    break;
-                case SDL_MOUSEBUTTONDOWN:
-                    handleTouch(game, ev);
-                    break;
-                case SDL_MOUSEBUTTONUP:
-                    handleTouchUp(game);
-                    break;
-                case SDL_MOUSEMOTION:
-                    if (ev.motion.state & SDL_BUTTON_LMASK)
-                        handleTouch(game, ev);
-                    break;
-            }
+        Uint64 eventsStart = profNow();
+        while (SDL_PollEvent(&ev)) handleEvent(ev);
+        flushTouches(game);
+        profAdd(PH_EVENTS, eventsStart);
+        
+        // Update: kick the sim thread and draw the newest finished world,
+        // or step it inline
+        const World* view = &game;
+        if (pipe) {
+            SDL_SemPost(pipe->kick);
+            bool fresh;
+            const FrameSnapshot& snap = pipe->snapshots.acquire(fresh);
+            if (fresh) g_prof.frame.mergeFrom(snap.prof);
+            view = &snap.world;
+        } else {
+            updateFrame(game, frameDt);
         }
+        if (game.quitRequested) running = false;
+        updateAudio();
+        const World& w = *view;
         
-        // Update
-        switch (game.state) {
-            case STATE_MENU:    break;
-            case STATE_PLAYING: updateGame(game); break;
-            case STATE_PAUSED:  break;
-            case STATE_GAMEOVER:
-                game.gameoverTimer += game.dt;
-                break;
-            default: break;
+        // The pipelined sim owns `game`; the snapshot it published is ours
+        if (suspendDue) {
+            saveSuspend(w, suspendPath);
+            suspendDue = false;
+        }
+        if (w.highScore > savedHighScore && !prefDir.empty()) {
+            savedHighScore = w.highScore;
+            saveHighScore(highScorePath, savedHighScore);
         }
         
         // Render
+        ensureRenderCaches(game);
         SDL_SetRenderDrawColor(game.renderer, 0, 0, 20, 255);
         SDL_RenderClear(game.renderer);
         
-        switch (game.state) {
-            case STATE_MENU:     drawMenu(game); break;
-            case STATE_PLAYING:  renderGame(game); break;
-            case STATE_PAUSED:   renderGame(game); drawPause(game); break;
-            case STATE_GAMEOVER: drawGameOver(game); break;
+        switch (w.state) {
+            case STATE_MENU:     drawMenu(game, w); break;
+            case STATE_PLAYING:  renderGame(game, w); break;
+            case STATE_PAUSED:   drawPausedGame(game, w); drawPause(game, w); break;
+            case STATE_GAMEOVER: drawGameOver(game, w); break;
             default: break;
         }
         
-        SDL_RenderPresent(game.renderer);
+        if (w.state != STATE_PAUSED) game.pauseValid = false;
+        if (w.state == STATE_GAMEOVER && shownState != STATE_GAMEOVER) saveTrace("game over");
+        shownState = w.state;
+        
+        drawProfilerOverlay(game, w);
+        
+        {
+            ProfileScope prof(PH_PRESENT);
+            flushPrims(game.renderer);
+            SDL_RenderPresent(game.renderer);
+        }
+        endWarmupFrame();
+        profAdd(PH_FRAME, now);
+        traceCounter(TC_BULLETS,   w.bullets.size());
+        traceCounter(TC_MISSILES,  w.missiles.size());
+        traceCounter(TC_ENEMIES,   w.enemies.size());
+        traceCounter(TC_PARTICLES, w.particles.live);
+        traceCounter(TC_DRAWS,     g_prof.drawCalls);
+        traceCounter(TC_STEPS,     g_prof.frame.simSteps);
+        if (game.net) traceCounter(TC_NET_BYTES, w.netStats.bytesOut + w.netStats.bytesIn);
+        traceCounter(TC_WARM_JOBS, g_warm.outstanding);
+        endProfileFrame();
+        updateQuality(w.state == STATE_PLAYING);
     }
     
+    if (pipe) {
+        stopPipeline(*pipe);
+        delete pipe;
+    }
+    shutdownJobs();
+    shutdownWarmup();
+    shutdownAudio();
+    if (canSuspend) saveSuspend(game, suspendPath);
+    netClose(game.net);
+    game.net = nullptr;
+    saveTrace("exit");
+    SDL_Log("Touch: %d motion samples coalesced", game.touch.coalesced);
+    SDL_Log("Idle: %d frames, %.1f s waiting for events", idleFrames, idleWaitMs / 1000.0f);
+    if (game.inputLog.replaying) logProfilerSummary();
+    SDL_Log("Quality: ended on %s after %d changes", qualityTier().name, g_quality.changes);
+    closeInputLog(game.inputLog, game.tick);
+    logPoolStats(game);
+    destroyRenderCaches(game);
     SDL_DestroyRenderer(game.renderer);
     SDL_DestroyWindow(game.window);
     SDL_Quit();
     return 0;
 }
+#endif // APEFIGHTER_HEADLESS
 
 /*
 =======================================================
@@ -1681,6 +6653,7 @@ int main(int argc, char* argv[]) {
   - MS button    - fire homing missile
   - BM button    - screen bomb (kills all enemies)
   - II button    - pause
+  - 3-finger tap - profiler overlay
   
   Keyboard (desktop testing):
   - Arrow keys / WASD - move (add if needed)
@@ -1688,6 +6661,8 @@ int main(int argc, char* argv[]) {
   - M      - missile
   - B      - bomb
   - P      - pause
+  - F3     - profiler overlay
+  - F4     - save the trace (with --trace PATH)
   - ESC    - quit
 =======================================================
 */